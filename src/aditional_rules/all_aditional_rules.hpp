@@ -5,6 +5,7 @@
 
 #include "aditional_rules/dilation.hpp"
 #include "aditional_rules/erosion.hpp"
+#include "aditional_rules/morphology.hpp"
 #include "aditional_rules/rotation_rule.hpp"
 #include "aditional_rules/wolfram_rules.hpp"
 #include "aditional_rules/line_completor.hpp"
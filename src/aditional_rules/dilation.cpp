@@ -1,4 +1,5 @@
 #include "dilation.hpp"
+#include "morphology.hpp"
 
 
 // Simple dilation rule that turns on dead cells if they have at least one alive neighbor
@@ -14,6 +15,12 @@ uint8_t DilationRule::apply(uint8_t current_state, std::vector<uint8_t> neighbou
   return current_state;
 }
 
+std::size_t DilationRule::fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                                 Neighborhood neighborhood, Boundary boundary, std::size_t generations) const {
+  morphology::dilate(cells, width, height, neighborhood, boundary, generations);
+  return generations;
+}
+
 std::string DilationRule::getName() const {
     return DILATION_RULE_NAME;
 }
@@ -20,6 +20,10 @@ public:
   // Turns cells on based on nearby active neighbors
   uint8_t apply(uint8_t current_state, std::vector<uint8_t> neighbours) const override;
 
+  // k generations in one pass (see morphology.hpp)
+  std::size_t fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                          Neighborhood neighborhood, Boundary boundary, std::size_t generations) const override;
+
   std::string getName() const override;
 
   // Auto-registers so the rule appears in the app
@@ -1,84 +1,317 @@
 #include "edge_detection.hpp"
 #include "core/grid.hpp"
+#include "core/parallel.hpp"
 #include "anti_convex_hull.hpp"
+#include <limits>
 
-// not used, this rule needs context for the neighborhood checks
-uint8_t EdgeDetectionRule::apply(uint8_t current_state, std::vector<uint8_t> neighbours) const {
-  return current_state;
+namespace {
+
+// Shared body for both neighborhoods: match line patterns, then grow edge bits from the neighbours along the edge direction
+// up/left are the indices of the N and W neighbours, their opposites sit half the neighbourhood further
+template <std::size_t N>
+uint8_t detect_and_grow(uint8_t current_state, const std::array<uint8_t, N>& configuration,
+                        const PatternTable<N>& horizontal, const PatternTable<N>& vertical,
+                        std::size_t up, std::size_t left) {
+  // only alive cells can start a new edge
+  if (is_alive(current_state)) {
+    const uint8_t alive_code = pack_code(configuration, 0x01);
+
+    if (horizontal.match(alive_code)) {
+      current_state = add_horizontal_edge_bit(current_state);
+    }
+    if (vertical.match(alive_code)) {
+      current_state = add_vertical_edge_bit(current_state);
+    }
+  }
+
+  // spread the edge bits
+  if (is_vertical_edge(configuration[up]) || is_vertical_edge(configuration[up + N / 2])) {
+    current_state = add_vertical_edge_bit(current_state);
+  }
+  if (is_horizontal_edge(configuration[left]) || is_horizontal_edge(configuration[left + N / 2])) {
+    current_state = add_horizontal_edge_bit(current_state);
+  }
+
+  if ((is_vertical_edge(current_state) || is_horizontal_edge(current_state)) && is_inside(current_state)) {
+    return current_state | 0x01; // set alive bit if it is an edge and was inside before
+  }
+
+  return make_dead(current_state); // does not match any configuration, kill the cell but keep the edge bits if they were set
 }
 
-// Rule that detects edges and then it grows them in that direction
-// WARNING: this rule is modified to work only within the inside space marked by rule "anti_convex_hull" so using it without it will not do anything
-uint8_t EdgeDetectionRule::apply(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
-  auto deltas = pick_deltas(ctx.getNeighborhood());
-  auto grid_values = ctx.getGrid().getGridValues();
+constexpr uint32_t NEVER = std::numeric_limits<uint32_t>::max();
 
-  if (current_state == OUTSIDE_CELL_VALUE) {
-    return current_state; // if the cell is already outside, it stays outside
+// Arrival-time solver behind EdgeDetectionRule::fastForward
+// Starts from the state after the first generation. From there on edge bits are only ever added and a cell is alive
+// exactly when it is inside and has an edge bit, so the whole run is described by the generation in which each bit appears
+// Growth along a row/column is filled in with scans; new pattern matches are only possible next to a cell that just
+// turned alive, so those are the only cells re-checked (in generation order, which keeps the result exact)
+template <std::size_t N>
+class EdgeArrival {
+public:
+  EdgeArrival(const std::vector<uint8_t>& first, std::size_t width, std::size_t height,
+              const std::array<std::pair<int,int>, N>& deltas,
+              const PatternTable<N>& horizontal_table, const PatternTable<N>& vertical_table)
+    : first_(first), width_(width), height_(height),
+      horizontal_table_(horizontal_table), vertical_table_(vertical_table),
+      passable_(first.size(), 0), horizontal_(first.size(), NEVER), vertical_(first.size(), NEVER), alive_(first.size(), NEVER) {
+    for (std::size_t i = 0; i < N; ++i) {
+      offsets_[i] = static_cast<std::ptrdiff_t>(deltas[i].second) * static_cast<std::ptrdiff_t>(width) + deltas[i].first;
+    }
   }
 
-  // load current neighborhood in configuration
-  if (ctx.getNeighborhood() == Neighborhood::Moore) {
-    deltas = pick_deltas(Neighborhood::Moore);
-    std::array<uint8_t, 8> configuration{};
-    for (std::size_t i = 0; i < deltas.size(); ++i) {
-      int nx = static_cast<int>(ctx.x) + deltas[i].first; 
-      int ny = static_cast<int>(ctx.y) + deltas[i].second;
-      if (nx < 0 || ny < 0 || nx >= static_cast<int>(ctx.getGrid().getWidth()) || ny >= static_cast<int>(ctx.getGrid().getHeight())) {
-        return 0; // out of bounds, kill the cell
-      }
-      configuration[i] = grid_values[ny * ctx.getGrid().getWidth() + nx];
-    }
-    bool match;
-    // try to match against edge horizontal patterns
-    for (const auto& config : moore_horizontal_lines) {
-      if (is_dead(current_state)) break;
-      match = true;
-      for (std::size_t i = 0; i < deltas.size(); ++i) {
-        if (config[i] != J && (configuration[i] & 0x01) != (config[i] & 0x01)) { // only compare alive/dead state for vertical lines
-          match = false;
-          break;
+  // Computes all arrival times, returns the generation in which the last change happens
+  uint32_t solve() {
+    seed();
+
+    // Generation 1 -> 2 is checked everywhere, later ones only around cells that turned alive
+    for (std::size_t i = 0; i < first_.size(); ++i) {
+      evaluate(i, 1);
+    }
+
+    for (uint32_t t = 2; t < pending_.size(); ++t) {
+      for (std::size_t k = 0; k < pending_[t].size(); ++k) {
+        const std::size_t c = pending_[t][k];
+        if (alive_[c] != t) continue; // superseded by an earlier arrival
+
+        evaluate(c, t);
+        for (auto offset : offsets_) {
+          evaluate(static_cast<std::size_t>(static_cast<std::ptrdiff_t>(c) + offset), t);
         }
       }
-      if (match) {
-        current_state = add_horizontal_edge_bit(current_state);
-        break;
+    }
+
+    uint32_t last = 1;
+    for (std::size_t i = 0; i < first_.size(); ++i) {
+      if (horizontal_[i] != NEVER) last = std::max(last, horizontal_[i]);
+      if (vertical_[i] != NEVER) last = std::max(last, vertical_[i]);
+    }
+    return last;
+  }
+
+  // Writes the state of the given generation (>= 1) into cells
+  void compose(std::vector<uint8_t>& cells, uint32_t generation) const {
+    for (std::size_t i = 0; i < first_.size(); ++i) {
+      if (!passable_[i]) {
+        cells[i] = first_[i];
+        continue;
       }
+
+      uint8_t state = static_cast<uint8_t>(first_[i] & ~(HORIZONTAL_EDGE_MASK | VERTICAL_EDGE_MASK | 0x01));
+      if (horizontal_[i] <= generation) state = add_horizontal_edge_bit(state);
+      if (vertical_[i] <= generation) state = add_vertical_edge_bit(state);
+
+      cells[i] = (alive_[i] <= generation) ? (state | 0x01) : state;
     }
-    // ty to match against vertical line patterns
-    for (const auto& config : moore_vertical_lines) {
-      if (is_dead(current_state)) break;
-      match = true;
-      for (std::size_t i = 0; i < deltas.size(); ++i) {
-        if (config[i] != J && (configuration[i] & 0x01) != (config[i] & 0x01)) { // only compare alive/dead state for vertical lines
-          match = false;
-          break;
-        }
-      } 
-      if (match) {
-        current_state = add_vertical_edge_bit(current_state);
-        break;
+  }
+
+private:
+  // Border and outside cells never carry edge bits and stop the growth
+  void seed() {
+    for (std::size_t y = 1; y + 1 < height_; ++y) {
+      for (std::size_t x = 1; x + 1 < width_; ++x) {
+        const std::size_t i = y * width_ + x;
+        if (first_[i] == OUTSIDE_CELL_VALUE) continue;
+
+        passable_[i] = 1;
+        if (is_horizontal_edge(first_[i])) horizontal_[i] = 1;
+        if (is_vertical_edge(first_[i])) vertical_[i] = 1;
       }
     }
-    // spread the edge bits
 
-    if (is_vertical_edge(configuration[0]) || is_vertical_edge(configuration[4])) {
-      current_state = add_vertical_edge_bit(current_state);
+    // Bits present after generation 1 grow one cell per generation: segmented min-plus scans per row / column
+    parallel_for(height_, [&](std::size_t y_begin, std::size_t y_end) {
+      for (std::size_t y = y_begin; y < y_end; ++y) {
+        scan(y * width_, 1, width_);
+      }
+    });
+
+    parallel_for(width_, [&](std::size_t x_begin, std::size_t x_end) {
+      for (std::size_t x = x_begin; x < x_end; ++x) {
+        scan(x, width_, height_);
+      }
+    });
+
+    for (std::size_t i = 0; i < first_.size(); ++i) {
+      if (!passable_[i] || !is_inside(first_[i])) continue;
+
+      alive_[i] = std::min(horizontal_[i], vertical_[i]);
+      if (alive_[i] != NEVER && alive_[i] > 1) {
+        push(alive_[i], i);
+      }
     }
-    if (is_horizontal_edge(configuration[2]) || is_horizontal_edge(configuration[6])) {
-      current_state = add_horizontal_edge_bit(current_state);
+  }
+
+  // Forward + backward pass over one line; stride 1 is a row (horizontal bits), stride width a column (vertical bits)
+  void scan(std::size_t start, std::size_t stride, std::size_t count) {
+    auto& times = (stride == 1) ? horizontal_ : vertical_;
+
+    for (std::size_t k = 1; k < count; ++k) {
+      const std::size_t i = start + k * stride;
+      const uint32_t prev = times[i - stride];
+      if (passable_[i] && prev != NEVER && prev + 1 < times[i]) times[i] = prev + 1;
+    }
+
+    for (std::size_t k = count - 1; k-- > 0;) {
+      const std::size_t i = start + k * stride;
+      const uint32_t next = times[i + stride];
+      if (passable_[i] && next != NEVER && next + 1 < times[i]) times[i] = next + 1;
+    }
+  }
+
+  // Pattern check of cell i in the state of generation t, a match adds the bit in generation t + 1
+  void evaluate(std::size_t i, uint32_t t) {
+    if (!passable_[i] || alive_[i] > t) return;
+
+    uint8_t alive_code = 0;
+    for (std::size_t k = 0; k < N; ++k) {
+      if (alive_[static_cast<std::size_t>(static_cast<std::ptrdiff_t>(i) + offsets_[k])] <= t) {
+        alive_code = static_cast<uint8_t>(alive_code | (1u << k));
+      }
+    }
+
+    if (horizontal_table_.match(alive_code)) relax(horizontal_, i, 1, t + 1);
+    if (vertical_table_.match(alive_code)) relax(vertical_, i, width_, t + 1);
+  }
+
+  // New edge source: grows both ways along its line until something blocks it or an earlier arrival is met
+  void relax(std::vector<uint32_t>& times, std::size_t i, std::size_t stride, uint32_t time) {
+    if (times[i] <= time) return;
+    arrive(times, i, time);
+
+    uint32_t t = time + 1;
+    for (std::size_t j = i + stride; passable_[j] && times[j] > t; j += stride, ++t) {
+      arrive(times, j, t);
     }
 
-    if ((is_vertical_edge(current_state) || is_horizontal_edge(current_state)) && is_inside(current_state)) {
-      return current_state | 0x01; // set alive bit if it is an edge and was inside before
+    t = time + 1;
+    for (std::size_t j = i - stride; passable_[j] && times[j] > t; j -= stride, ++t) {
+      arrive(times, j, t);
     }
+  }
 
-    return make_dead(current_state); // does not match any configuration, kill the cell but keep the edge bits if they were set
-  } else if (ctx.getNeighborhood() == Neighborhood::VonNeumann) { 
+  void arrive(std::vector<uint32_t>& times, std::size_t i, uint32_t time) {
+    times[i] = time;
 
+    if (is_inside(first_[i]) && time < alive_[i]) {
+      alive_[i] = time;
+      push(time, i);
+    }
   }
+
+  void push(uint32_t time, std::size_t i) {
+    if (pending_.size() <= time) pending_.resize(time + 1);
+    pending_[time].push_back(i);
+  }
+
+  const std::vector<uint8_t>& first_;
+  std::size_t width_;
+  std::size_t height_;
+  const PatternTable<N>& horizontal_table_;
+  const PatternTable<N>& vertical_table_;
+  std::array<std::ptrdiff_t, N> offsets_{};
+
+  std::vector<uint8_t> passable_;
+  std::vector<uint32_t> horizontal_; // generation in which the horizontal edge bit appears
+  std::vector<uint32_t> vertical_;
+  std::vector<uint32_t> alive_;      // generation from which the cell is alive
+  std::vector<std::vector<uint32_t>> pending_; // cells by the generation they turned alive
+};
+
+template <std::size_t N>
+std::size_t solve_edges(std::vector<uint8_t>& cells, const std::vector<uint8_t>& first, std::size_t width, std::size_t height,
+                        const std::array<std::pair<int,int>, N>& deltas,
+                        const PatternTable<N>& horizontal_table, const PatternTable<N>& vertical_table, std::size_t generations) {
+  EdgeArrival<N> arrival(first, width, height, deltas, horizontal_table, vertical_table);
+  const std::size_t converged = arrival.solve();
+  const std::size_t advanced = std::min(generations, converged);
+
+  arrival.compose(cells, static_cast<uint32_t>(advanced));
+  return advanced;
+}
+
+} // namespace
+
+// not used, this rule needs context for the neighborhood checks
+uint8_t EdgeDetectionRule::apply(uint8_t current_state, std::vector<uint8_t> neighbours) const {
   return current_state;
+}
+
+// Rule that detects edges and then it grows them in that direction
+// WARNING: this rule is modified to work only within the inside space marked by rule "anti_convex_hull" so using it without it will not do anything
+uint8_t EdgeDetectionRule::apply(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
+  if (current_state == OUTSIDE_CELL_VALUE) {
+    return current_state; // if the cell is already outside, it stays outside
+  }
+
+  const Grid& grid = ctx.getGrid();
+  const std::size_t width = grid.getWidth();
+
+  if (ctx.x == 0 || ctx.y == 0 || ctx.x + 1 >= width || ctx.y + 1 >= grid.getHeight()) {
+    return 0; // out of bounds, kill the cell
+  }
+
+  // load current neighborhood in configuration (reference to the grid, this runs per cell)
+  const auto& grid_values = grid.getGridValues();
+
+  if (ctx.getNeighborhood() == Neighborhood::Moore) {
+    auto configuration = gather_neighbours(grid_values, ctx.x, ctx.y, width, deltas_moore);
+    return detect_and_grow(current_state, configuration, moore_horizontal_table, moore_vertical_table, 0, 2);
+  } else if (ctx.getNeighborhood() == Neighborhood::VonNeumann) {
+    auto configuration = gather_neighbours(grid_values, ctx.x, ctx.y, width, deltas_vonneumann);
+    return detect_and_grow(current_state, configuration, vonneumann_horizontal_table, vonneumann_vertical_table, 0, 1);
+  }
+
+  return current_state;
+}
+
+// Accelerated mode, see EdgeArrival above
+std::size_t EdgeDetectionRule::fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                                           Neighborhood neighborhood, Boundary boundary, std::size_t generations) const {
+  if (generations == 0 || cells.size() != width * height) return 0;
+  if (neighborhood != Neighborhood::Moore && neighborhood != Neighborhood::VonNeumann) return 0;
+
+  std::vector<uint8_t> initial;
+  if (verify_fast_forward_) initial = cells;
+
+  // The first generation is the only one that kills cells without edge bits, so it is stepped normally
+  Grid grid(width, height, 0, boundary, neighborhood);
+  grid.setGridValues(cells);
+  grid.step(*this);
+  const std::vector<uint8_t>& first = grid.getGridValues();
+
+  std::size_t advanced = 1;
+  if (generations == 1 || width < 3 || height < 3) {
+    cells = first;
+  } else if (neighborhood == Neighborhood::Moore) {
+    advanced = solve_edges(cells, first, width, height, deltas_moore, moore_horizontal_table, moore_vertical_table, generations);
+  } else {
+    advanced = solve_edges(cells, first, width, height, deltas_vonneumann, vonneumann_horizontal_table, vonneumann_vertical_table, generations);
+  }
+
+  if (verify_fast_forward_) {
+    Grid reference(width, height, 0, boundary, neighborhood);
+    reference.setGridValues(initial);
+    for (std::size_t i = 0; i < advanced; ++i) {
+      reference.step(*this);
+    }
+
+    std::vector<uint8_t> stepped = reference.getGridValues();
+    bool matches = (stepped == cells);
+
+    // Stopping early claims a fixed point, so one more step must not change anything
+    if (matches && advanced < generations) {
+      reference.step(*this);
+      matches = (reference.getGridValues() == cells);
+    }
+
+    if (!matches) {
+      fast_forward_mismatches_.fetch_add(1, std::memory_order_relaxed);
+      cells = std::move(stepped);
+    }
+  }
 
+  return advanced;
 }
 
 std::string EdgeDetectionRule::getName() const {
@@ -4,6 +4,7 @@
 #include "core/rule_registry.hpp"
 #include "shape_enforcement_rule.hpp" // for J wildcard and pattern matching
 #include <array>
+#include <atomic>
 
 inline constexpr const char* EDGE_DETECTION_RULE_NAME = "Edge Detection Rule";
 
@@ -23,6 +24,23 @@ constexpr std::array<std::array<uint8_t, 8>, 2> moore_vertical_lines = {{
   {1,J,J,J,1,0,0,0},
 }};
 
+// Von Neumann versions (order N, W, S, E)
+constexpr std::array<std::array<uint8_t, 4>, 2> vonneumann_horizontal_lines = {{
+  {J,1,0,1},
+  {0,1,J,1},
+}};
+
+constexpr std::array<std::array<uint8_t, 4>, 2> vonneumann_vertical_lines = {{
+  {1,J,1,0},
+  {1,0,1,J},
+}};
+
+// Compiled lookup tables (alive bit only, see core/pattern_table.hpp)
+inline constexpr auto moore_horizontal_table = compile_patterns(moore_horizontal_lines, J);
+inline constexpr auto moore_vertical_table = compile_patterns(moore_vertical_lines, J);
+inline constexpr auto vonneumann_horizontal_table = compile_patterns(vonneumann_horizontal_lines, J);
+inline constexpr auto vonneumann_vertical_table = compile_patterns(vonneumann_vertical_lines, J);
+
 constexpr uint8_t HORIZONTAL_EDGE_MASK = 0x08; 
 constexpr uint8_t VERTICAL_EDGE_MASK = 0x04;
 
@@ -82,9 +100,25 @@ public:
 
   std::string getName() const override;
 
+  // Accelerated mode: jumps straight to the generation `generations` ahead (or to the fixed point if it comes sooner)
+  // Edge bits only ever get added, so instead of one neighbour per generation the arrival time of every edge bit is
+  // computed with row/column scans inside the inside regions; the result is the same state stepping would give
+  std::size_t fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                          Neighborhood neighborhood, Boundary boundary, std::size_t generations) const override;
+
+  // Verification switch: when on, fastForward also steps the plain rule and compares both results
+  // On a mismatch it keeps the stepped result and counts it
+  void setVerifyFastForward(bool verify) { verify_fast_forward_ = verify; }
+  bool isVerifyingFastForward() const { return verify_fast_forward_; }
+  std::size_t getFastForwardMismatches() const { return fast_forward_mismatches_.load(std::memory_order_relaxed); }
+
   // Auto-registers rule for UI selection
   inline static AutoRegisterRule<EdgeDetectionRule> auto_register_edge_detection{
     EDGE_DETECTION_RULE_NAME,
     ""
   };
+
+private:
+  bool verify_fast_forward_ = false;
+  mutable std::atomic<std::size_t> fast_forward_mismatches_ = 0;
 };
@@ -1,4 +1,5 @@
 #include "erosion.hpp"
+#include "morphology.hpp"
 
 // Morphological erosion: removes cells that are near empty space
 uint8_t ErosionRule::apply(uint8_t current_state, std::vector<uint8_t> neighbours) const {
@@ -11,6 +12,12 @@ uint8_t ErosionRule::apply(uint8_t current_state, std::vector<uint8_t> neighbour
   return current_state;
 }
 
+std::size_t ErosionRule::fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                                 Neighborhood neighborhood, Boundary boundary, std::size_t generations) const {
+  morphology::erode(cells, width, height, neighborhood, boundary, generations);
+  return generations;
+}
+
 std::string ErosionRule::getName() const {
     return EROSION_RULE_NAME;
 }
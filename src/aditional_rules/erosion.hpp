@@ -19,6 +19,10 @@ public:
   ~ErosionRule() override = default;
 
   uint8_t apply(uint8_t current_state, std::vector<uint8_t> neighbours) const override;
+  // k generations in one pass (see morphology.hpp)
+  std::size_t fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                          Neighborhood neighborhood, Boundary boundary, std::size_t generations) const override;
+
   std::string getName() const override;
 
   inline static AutoRegisterRule<ErosionRule> auto_register{EROSION_RULE_NAME, "Erosion rule that removes isolated cells."};
@@ -1,5 +1,6 @@
 #include "line_completor.hpp"
 #include "core/grid.hpp"
+#include <charconv>
 
 // Context-free version does nothing; this rule needs position + wider grid access
 uint8_t LineCompletorRule::apply(uint8_t current_state, std::vector<uint8_t> neighbours) const {
@@ -41,6 +42,20 @@ std::string LineCompletorRule::getName() const {
     return LINE_COMPLETOR_RULE_NAME;
 }
 
+std::string LineCompletorRule::getParameters() const {
+  return std::to_string(line_radius_);
+}
+
+bool LineCompletorRule::setParameters(const std::string& parameters) const {
+  std::size_t line_radius = 0;
+  const char* end = parameters.data() + parameters.size();
+  const auto [ptr, ec] = std::from_chars(parameters.data(), end, line_radius);
+  if (ec != std::errc() || ptr != end) return false;
+
+  line_radius_ = line_radius;
+  return true;
+}
+
 // this ended up being not used but it is for sure useful to add it later so for now I just left it here
 // in this state
 void LineCompletorRule::setLineRadius(std::size_t line_radius_) const {
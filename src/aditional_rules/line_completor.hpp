@@ -26,8 +26,15 @@ public:
   // Main version uses ctx to sample wider area (radius-based logic)
   uint8_t apply(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const override;
 
+  // apply writes line_radius_ from every worker thread, so it can't promise replays
+  bool isDeterministic() const override { return false; }
+
   std::string getName() const override;
 
+  // Line radius as a decimal number
+  std::string getParameters() const override;
+  bool setParameters(const std::string& parameters) const override;
+
   // Allows changing radius even on const instance (used from UI)
   void setLineRadius(std::size_t line_radius) const;
 
@@ -0,0 +1,492 @@
+#include "morphology.hpp"
+#include "core/parallel.hpp"
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <limits>
+
+namespace {
+
+// How cells beyond the edge take part in a transform
+// Reflect/Clamp only ever repeat cells that are already in the neighbourhood (or the cell itself), so they act like Skip
+enum class Outside : uint8_t {
+  Skip,   // outside does not exist
+  Source, // every outside cell is a source (Zero for erosion, One for dilation)
+  Wrap    // torus
+};
+
+// Grid::getNeighborsStatic samples no neighbours at all for Clamp (and unknown values), cells then only see themselves
+bool has_neighbours(Boundary boundary) {
+  return boundary == Boundary::Wrap || boundary == Boundary::Reflect || boundary == Boundary::Zero || boundary == Boundary::One;
+}
+
+Outside erosion_outside(Boundary boundary) {
+  if (boundary == Boundary::Wrap) return Outside::Wrap;
+  return boundary == Boundary::Zero ? Outside::Source : Outside::Skip;
+}
+
+Outside dilation_outside(Boundary boundary) {
+  if (boundary == Boundary::Wrap) return Outside::Wrap;
+  return boundary == Boundary::One ? Outside::Source : Outside::Skip;
+}
+
+long wrap(long v, long size) {
+  v %= size;
+  return v < 0 ? v + size : v;
+}
+
+// Distances never exceed width + height, so bigger k behaves exactly like this one
+uint32_t effective_k(std::size_t k, std::size_t width, std::size_t height) {
+  return static_cast<uint32_t>(std::min<std::size_t>(k, width + height + 1));
+}
+
+// Generation in which something spreading from the source cells reaches each cell (BFS distance in the
+// neighbourhood graph: chessboard for Moore, city block for Von Neumann), saturated at cap
+// Two raster passes are exact on a rectangle, on a torus the passes repeat until nothing changes
+std::vector<uint32_t> distance_transform(const std::vector<uint8_t>& cells, bool sources_are_foreground,
+                                         std::size_t width, std::size_t height, Neighborhood neighborhood,
+                                         Outside outside, uint32_t cap) {
+  std::vector<uint32_t> dist(cells.size());
+  for (std::size_t i = 0; i < cells.size(); ++i) {
+    dist[i] = morphology::is_foreground(cells[i]) == sources_are_foreground ? 0 : cap;
+  }
+
+  // forward pass looks at neighbours it already visited (above or to the left), backward pass at the rest
+  std::vector<std::pair<int,int>> forward, backward;
+  for (const auto& delta : pick_deltas(neighborhood)) {
+    const bool before = delta.second < 0 || (delta.second == 0 && delta.first < 0);
+    (before ? forward : backward).push_back(delta);
+  }
+
+  const long w = static_cast<long>(width);
+  const long h = static_cast<long>(height);
+
+  auto relax = [&](long x, long y, const std::vector<std::pair<int,int>>& deltas) {
+    uint32_t& d = dist[idx(x, y, width)];
+    bool changed = false;
+
+    for (const auto& delta : deltas) {
+      long nx = x + delta.first;
+      long ny = y + delta.second;
+      uint32_t nd;
+
+      if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+        if (outside == Outside::Skip) continue;
+        nd = outside == Outside::Source ? 0 : dist[idx(wrap(nx, w), wrap(ny, h), width)];
+      } else {
+        nd = dist[idx(nx, ny, width)];
+      }
+
+      if (nd + 1 < d) {
+        d = nd + 1;
+        changed = true;
+      }
+    }
+    return changed;
+  };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (long y = 0; y < h; ++y) {
+      for (long x = 0; x < w; ++x) {
+        changed |= relax(x, y, forward);
+      }
+    }
+    for (long y = h - 1; y >= 0; --y) {
+      for (long x = w - 1; x >= 0; --x) {
+        changed |= relax(x, y, backward);
+      }
+    }
+    if (outside != Outside::Wrap) break;
+  }
+
+  return dist;
+}
+
+// van Herk / Gil-Werman running min/max over windows of 2r+1 values
+// Costs three comparisons per value no matter how big r is
+class RunningExtreme {
+public:
+  RunningExtreme(std::size_t radius, bool take_max, Outside outside, uint8_t pad)
+    : radius_(radius), take_max_(take_max), outside_(outside), pad_(pad) {}
+
+  // Filters n values read with stride `in_stride` and writes them with stride `out_stride`
+  void run(const uint8_t* in, std::size_t n, std::size_t in_stride, uint8_t* out, std::size_t out_stride) {
+    const std::size_t window = 2 * radius_ + 1;
+    const std::size_t length = n + 2 * radius_;
+    line_.resize(length);
+    prefix_.resize(length);
+    suffix_.resize(length);
+
+    // line with radius_ padding values on both sides
+    const long r = static_cast<long>(radius_);
+    const long size = static_cast<long>(n);
+    for (long p = 0; p < static_cast<long>(length); ++p) {
+      const long pos = p - r;
+      if (pos >= 0 && pos < size) {
+        line_[p] = in[pos * in_stride];
+      } else if (outside_ == Outside::Wrap) {
+        line_[p] = in[wrap(pos, size) * in_stride];
+      } else {
+        line_[p] = pad_;
+      }
+    }
+
+    // extremes from the block start up to i and from i up to the block end, blocks are one window wide
+    for (std::size_t i = 0; i < length; ++i) {
+      prefix_[i] = i % window == 0 ? line_[i] : pick(prefix_[i - 1], line_[i]);
+    }
+    for (std::size_t i = length; i-- > 0;) {
+      suffix_[i] = (i + 1 == length || (i + 1) % window == 0) ? line_[i] : pick(suffix_[i + 1], line_[i]);
+    }
+
+    // every window spans at most two blocks
+    for (std::size_t j = 0; j < n; ++j) {
+      out[j * out_stride] = pick(suffix_[j], prefix_[j + window - 1]);
+    }
+  }
+
+private:
+  uint8_t pick(uint8_t a, uint8_t b) const { return take_max_ ? std::max(a, b) : std::min(a, b); }
+
+  std::size_t radius_;
+  bool take_max_;
+  Outside outside_;
+  uint8_t pad_;
+  std::vector<uint8_t> line_, prefix_, suffix_;
+};
+
+// Min/max of a 0/1 mask over the (2r+1)^2 square, done as a row pass followed by a column pass
+std::vector<uint8_t> square_filter(const std::vector<uint8_t>& mask, std::size_t width, std::size_t height,
+                                   std::size_t radius, bool take_max, Outside outside, uint8_t pad) {
+  if (radius == 0) return mask;
+
+  std::vector<uint8_t> rows(mask.size());
+  std::vector<uint8_t> result(mask.size());
+
+  parallel_for(height, [&](std::size_t y_begin, std::size_t y_end) {
+    RunningExtreme filter(radius, take_max, outside, pad);
+    for (std::size_t y = y_begin; y < y_end; ++y) {
+      filter.run(&mask[y * width], width, 1, &rows[y * width], 1);
+    }
+  });
+
+  parallel_for(width, [&](std::size_t x_begin, std::size_t x_end) {
+    RunningExtreme filter(radius, take_max, outside, pad);
+    for (std::size_t x = x_begin; x < x_end; ++x) {
+      filter.run(&rows[x], height, width, &result[x], width);
+    }
+  });
+
+  return result;
+}
+
+std::vector<uint8_t> foreground_mask(const std::vector<uint8_t>& cells) {
+  std::vector<uint8_t> mask(cells.size());
+  for (std::size_t i = 0; i < cells.size(); ++i) {
+    mask[i] = morphology::is_foreground(cells[i]) ? 1 : 0;
+  }
+  return mask;
+}
+
+// Erosion result from the erosion distance: survives past k, loses its alive bits at exactly k, cleared before that
+uint8_t eroded_value(uint8_t state, uint32_t distance, uint32_t k) {
+  if (distance > k) return state;
+  if (distance == k) return state & 0xFC;
+  return 0;
+}
+
+// Value a newly grown cell copies: the first neighbour (in neighbourhood order) that was foreground one generation earlier
+// `distance_at` returns the arrival generation of a neighbour or nothing when the neighbour is skipped
+template <class DistanceAt, class ValueAt>
+uint8_t grown_value(uint32_t distance, Neighborhood neighborhood, DistanceAt distance_at, ValueAt value_at) {
+  const auto deltas = pick_deltas(neighborhood);
+  for (std::size_t n = 0; n < deltas.size(); ++n) {
+    uint32_t nd;
+    if (distance_at(deltas[n], nd) && nd + 1 == distance) {
+      return value_at(deltas[n]);
+    }
+  }
+  return 0; // unreachable, some neighbour is always one generation closer
+}
+
+} // namespace
+
+namespace morphology {
+
+void erode(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+           Neighborhood neighborhood, Boundary boundary, std::size_t k) {
+  if (k == 0 || cells.empty()) return;
+
+  if (!has_neighbours(boundary)) {
+    // nothing ever touches the background, so only the first generation (clearing it) does anything
+    for (auto& cell : cells) {
+      if (!is_foreground(cell)) cell = 0;
+    }
+    return;
+  }
+
+  const Outside outside = erosion_outside(boundary);
+  const uint32_t steps = effective_k(k, width, height);
+
+  if (neighborhood == Neighborhood::Moore) {
+    // square element: min filter of the foreground mask, radius k gives survivors, radius k-1 the cells dying last
+    const auto mask = foreground_mask(cells);
+    const uint8_t pad = outside == Outside::Source ? 0 : 1;
+    const auto survives = square_filter(mask, width, height, steps, false, outside, pad);
+    const auto reached_last = square_filter(mask, width, height, steps - 1, false, outside, pad);
+
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+      if (survives[i]) continue;
+      cells[i] = reached_last[i] ? cells[i] & 0xFC : 0;
+    }
+    return;
+  }
+
+  // diamond is not separable into line filters, city block distance to the background gives the same answer
+  const auto dist = distance_transform(cells, false, width, height, neighborhood, outside, steps + 1);
+  for (std::size_t i = 0; i < cells.size(); ++i) {
+    cells[i] = eroded_value(cells[i], dist[i], steps);
+  }
+}
+
+void dilate(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+            Neighborhood neighborhood, Boundary boundary, std::size_t k) {
+  if (k == 0 || cells.empty() || !has_neighbours(boundary)) return;
+
+  const Outside outside = dilation_outside(boundary);
+  const uint32_t steps = effective_k(k, width, height);
+
+  // Grown cells copy values, so a plain max filter is only enough when every source carries the same value
+  bool uniform = true;
+  bool has_value = outside == Outside::Source;
+  uint8_t value = 1; // value of outside cells under Boundary::One
+  for (auto cell : cells) {
+    if (!is_foreground(cell)) continue;
+    if (!has_value) {
+      value = cell;
+      has_value = true;
+    } else if (cell != value) {
+      uniform = false;
+      break;
+    }
+  }
+  if (!has_value) return; // nothing to grow from
+
+  if (neighborhood == Neighborhood::Moore && uniform) {
+    const uint8_t pad = outside == Outside::Source ? 1 : 0;
+    const auto grown = square_filter(foreground_mask(cells), width, height, steps, true, outside, pad);
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+      if (grown[i] && !is_foreground(cells[i])) cells[i] = value;
+    }
+    return;
+  }
+
+  const auto dist = distance_transform(cells, true, width, height, neighborhood, outside, steps + 1);
+
+  // Cells sorted by arrival generation so every neighbour they copy from is already final
+  std::vector<std::size_t> bucket_start(steps + 2, 0);
+  for (auto d : dist) {
+    if (d >= 1 && d <= steps) ++bucket_start[d + 1];
+  }
+  for (std::size_t d = 1; d < bucket_start.size(); ++d) {
+    bucket_start[d] += bucket_start[d - 1];
+  }
+  std::vector<std::size_t> order(bucket_start.back());
+  for (std::size_t i = 0; i < dist.size(); ++i) {
+    if (dist[i] >= 1 && dist[i] <= steps) order[bucket_start[dist[i]]++] = i;
+  }
+
+  const long w = static_cast<long>(width);
+  const long h = static_cast<long>(height);
+
+  for (auto i : order) {
+    const long x = static_cast<long>(i % width);
+    const long y = static_cast<long>(i / width);
+
+    // resolves a neighbour offset to a cell index, -1 for an outside source, nothing for a skipped neighbour
+    auto locate = [&](const std::pair<int,int>& delta, long& at) {
+      long nx = x + delta.first;
+      long ny = y + delta.second;
+      if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+        if (outside == Outside::Skip) return false;
+        if (outside == Outside::Source) {
+          at = -1;
+          return true;
+        }
+        nx = wrap(nx, w);
+        ny = wrap(ny, h);
+      }
+      at = static_cast<long>(idx(nx, ny, width));
+      return true;
+    };
+
+    cells[i] = grown_value(dist[i], neighborhood,
+      [&](const std::pair<int,int>& delta, uint32_t& nd) {
+        long at;
+        if (!locate(delta, at)) return false;
+        nd = at < 0 ? 0 : dist[at];
+        return true;
+      },
+      [&](const std::pair<int,int>& delta) {
+        long at = -1;
+        locate(delta, at);
+        return at < 0 ? uint8_t{1} : cells[at]; // outside cells under Boundary::One read as 1
+      });
+  }
+}
+
+} // namespace morphology
+
+uint8_t MorphologyRule::apply(uint8_t current_state, std::vector<uint8_t> neighbours) const {
+  return current_state;
+}
+
+// Same distances as the whole-grid kernels, but searched inside the radius-k window around this cell only
+// Everything the result depends on lies inside that window, so the answer is exact
+uint8_t MorphologyRule::apply(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
+  const Grid& grid = ctx.getGrid();
+  const std::size_t width = grid.getWidth();
+  const std::size_t height = grid.getHeight();
+  const auto& cells = grid.getGridValues();
+
+  const uint32_t k = effective_k(iterations_, width, height);
+  if (k == 0) return current_state;
+
+  const bool erode = op_ == MorphologyOp::Erode;
+  if (!has_neighbours(ctx.getBoundary())) {
+    return erode && !morphology::is_foreground(current_state) ? 0 : current_state;
+  }
+
+  const Outside outside = erode ? erosion_outside(ctx.getBoundary()) : dilation_outside(ctx.getBoundary());
+
+  // window cell kinds
+  constexpr uint8_t BLOCKED = 0; // outside and skipped
+  constexpr uint8_t CELL = 1;
+  constexpr uint8_t OUTSIDE_SOURCE = 2;
+  constexpr uint32_t FAR = std::numeric_limits<uint32_t>::max();
+
+  const long side = 2 * static_cast<long>(k) + 1;
+  const long w = static_cast<long>(width);
+  const long h = static_cast<long>(height);
+  const long origin_x = static_cast<long>(ctx.x) - static_cast<long>(k);
+  const long origin_y = static_cast<long>(ctx.y) - static_cast<long>(k);
+
+  thread_local std::vector<uint8_t> kind;
+  thread_local std::vector<std::size_t> cell_index;
+  thread_local std::vector<uint32_t> dist;
+  thread_local std::deque<long> queue;
+  kind.assign(side * side, BLOCKED);
+  cell_index.assign(side * side, 0);
+  dist.assign(side * side, FAR);
+  queue.clear();
+
+  for (long wy = 0; wy < side; ++wy) {
+    for (long wx = 0; wx < side; ++wx) {
+      const long p = wy * side + wx;
+      long gx = origin_x + wx;
+      long gy = origin_y + wy;
+
+      if (gx < 0 || gy < 0 || gx >= w || gy >= h) {
+        if (outside == Outside::Skip) continue;
+        if (outside == Outside::Source) {
+          kind[p] = OUTSIDE_SOURCE;
+          dist[p] = 0;
+          queue.push_back(p);
+          continue;
+        }
+        gx = wrap(gx, w);
+        gy = wrap(gy, h);
+      }
+
+      kind[p] = CELL;
+      cell_index[p] = idx(gx, gy, width);
+      // erosion spreads from the background, dilation from the foreground
+      if (morphology::is_foreground(cells[cell_index[p]]) != erode) {
+        dist[p] = 0;
+        queue.push_back(p);
+      }
+    }
+  }
+
+  const auto deltas = pick_deltas(ctx.getNeighborhood());
+  while (!queue.empty()) {
+    const long p = queue.front();
+    queue.pop_front();
+    if (dist[p] >= k) continue;
+
+    const long px = p % side;
+    const long py = p / side;
+    for (const auto& delta : deltas) {
+      const long nx = px + delta.first;
+      const long ny = py + delta.second;
+      if (nx < 0 || ny < 0 || nx >= side || ny >= side) continue;
+
+      const long n = ny * side + nx;
+      if (kind[n] == BLOCKED || dist[n] != FAR) continue;
+      dist[n] = dist[p] + 1;
+      queue.push_back(n);
+    }
+  }
+
+  const long center = static_cast<long>(k) * side + static_cast<long>(k);
+  if (erode) {
+    return eroded_value(current_state, dist[center], k);
+  }
+
+  if (dist[center] == 0 || dist[center] > k) return current_state;
+
+  // walk back towards the source the same way the generations copied the value
+  long p = center;
+  while (dist[p] > 0) {
+    const long px = p % side;
+    const long py = p / side;
+    auto neighbour = [&](const std::pair<int,int>& delta) { return (py + delta.second) * side + (px + delta.first); };
+
+    long next = p;
+    grown_value(dist[p], ctx.getNeighborhood(),
+      [&](const std::pair<int,int>& delta, uint32_t& nd) {
+        const long n = neighbour(delta);
+        if (kind[n] == BLOCKED) return false;
+        nd = dist[n];
+        return true;
+      },
+      [&](const std::pair<int,int>& delta) {
+        next = neighbour(delta);
+        return uint8_t{0};
+      });
+    p = next;
+  }
+
+  return kind[p] == OUTSIDE_SOURCE ? uint8_t{1} : cells[cell_index[p]];
+}
+
+std::size_t MorphologyRule::fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                                        Neighborhood neighborhood, Boundary boundary, std::size_t generations) const {
+  const std::size_t k = iterations_ * generations;
+  if (op_ == MorphologyOp::Erode) {
+    morphology::erode(cells, width, height, neighborhood, boundary, k);
+  } else {
+    morphology::dilate(cells, width, height, neighborhood, boundary, k);
+  }
+  return generations;
+}
+
+std::string MorphologyRule::getName() const {
+  return op_ == MorphologyOp::Erode ? K_STEP_EROSION_RULE_NAME : K_STEP_DILATION_RULE_NAME;
+}
+
+std::string MorphologyRule::getParameters() const {
+  return std::to_string(iterations_);
+}
+
+bool MorphologyRule::setParameters(const std::string& parameters) const {
+  std::size_t iterations = 0;
+  const char* end = parameters.data() + parameters.size();
+  const auto [ptr, ec] = std::from_chars(parameters.data(), end, iterations);
+  if (ec != std::errc() || ptr != end || iterations == 0) return false;
+
+  iterations_ = iterations;
+  return true;
+}
@@ -8,46 +8,38 @@ uint8_t ShapeEnforcement::apply(uint8_t current_state, std::vector<uint8_t> neig
 
 // Keeps cells only if their local shape matches a known line/corner pattern meaning it preserves shapes that could represent rectangles (used for thesis)
 uint8_t ShapeEnforcement::apply(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
-  if (current_state == 0) { 
+  if (current_state == 0) {
     return 0; // dead stays dead
   }
 
-  auto deltas = pick_deltas(ctx.getNeighborhood());
-  auto grid_values = ctx.getGrid().getGridValues();
+  const Grid& grid = ctx.getGrid();
+  const std::size_t width = grid.getWidth();
 
-  if (ctx.getNeighborhood() == Neighborhood::Moore) {
-    deltas = pick_deltas(Neighborhood::Moore);
-
-    std::array<uint8_t, 8> configuration{};
+  // border cells are unsafe for this pattern check (both neighborhoods reach outside there)
+  if (ctx.x == 0 || ctx.y == 0 || ctx.x + 1 >= width || ctx.y + 1 >= grid.getHeight()) {
+    return 0;
+  }
 
-    for (std::size_t i = 0; i < deltas.size(); ++i) {
-      int nx = static_cast<int>(ctx.x) + deltas[i].first; 
-      int ny = static_cast<int>(ctx.y) + deltas[i].second;
+  // Reference, not a copy: this runs for every cell of the grid
+  const auto& grid_values = grid.getGridValues();
 
-      if (nx < 0 || ny < 0 || nx >= static_cast<int>(ctx.getGrid().getWidth()) || ny >= static_cast<int>(ctx.getGrid().getHeight())) {
-        return 0; // border cells are unsafe for this pattern check
-      }
+  // Match against allowed local shapes via the compiled tables; a neighbour matches a 0/1 entry only if its mark bit is clear
+  if (ctx.getNeighborhood() == Neighborhood::Moore) {
+    auto configuration = gather_neighbours(grid_values, ctx.x, ctx.y, width, deltas_moore);
 
-      configuration[i] = grid_values[ny * ctx.getGrid().getWidth() + nx];
+    if (moore_clearing_table.match(pack_code(configuration, 0x01), pack_code(configuration, 0x02))) {
+      return current_state;
     }
 
-    // Match against allowed local shapes; J means "don't care"
-    for (const auto& config : moore_clearing_configs) {
-      bool match = true;
-
-      for (std::size_t i = 0; i < deltas.size(); ++i) {
-        if (config[i] != J && (configuration[i] & 0x03) != (config[i] & 0x03)) {
-          match = false;
-          break;
-        }
-      }
+    return current_state & 0xFC; // clear alive/mark bits, keep metadata
+  } else if (ctx.getNeighborhood() == Neighborhood::VonNeumann) {
+    auto configuration = gather_neighbours(grid_values, ctx.x, ctx.y, width, deltas_vonneumann);
 
-      if (match) return current_state;
+    if (vonneumann_clearing_table.match(pack_code(configuration, 0x01), pack_code(configuration, 0x02))) {
+      return current_state;
     }
 
-    return current_state & 0xFC; // clear alive/mark bits, keep metadata
-  } else if (ctx.getNeighborhood() == Neighborhood::VonNeumann) { 
-    // TODO: add Von Neumann cleanup patterns this isnt useful for us right now
+    return current_state & 0xFC;
   }
 
   return current_state;
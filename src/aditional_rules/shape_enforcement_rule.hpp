@@ -2,6 +2,7 @@
 
 #include "core/rule.hpp"
 #include "core/rule_registry.hpp"
+#include "core/pattern_table.hpp"
 #include <array>
 
 inline constexpr const char* SHAPE_ENFORCEMENT_RULE = "Shape Enforcement";
@@ -44,6 +45,26 @@ constexpr std::array<std::array<uint8_t, 8>, 4> moore_only_corners_clearing_conf
   {1,0,0,0,0,0,1,J}
 }};
 
+// Von Neumann counterparts (order N, W, S, E): straight lines with one empty side and plain corners
+// The shifted corner variants need diagonal cells so they have no Von Neumann version
+constexpr std::array<std::array<uint8_t, 4>, 8> vonneumann_clearing_configs = {{
+  // lines
+  {J,1,0,1},
+  {0,1,J,1},
+  {1,J,1,0},
+  {1,0,1,J},
+
+  // corners
+  {0,0,1,1},
+  {0,1,1,0},
+  {1,1,0,0},
+  {1,0,0,1}
+}};
+
+// Compiled lookup tables for the pattern sets above (see core/pattern_table.hpp)
+inline constexpr auto moore_clearing_table = compile_patterns(moore_clearing_configs, J);
+inline constexpr auto vonneumann_clearing_table = compile_patterns(vonneumann_clearing_configs, J);
+
 // Rule that removes "invalid" cells based on neighborhood patterns currently the pattern is tailored to preserve only shapes that could represent rectangle
 class ShapeEnforcement: public Rule {
 public:
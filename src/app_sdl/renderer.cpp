@@ -5,8 +5,12 @@
 #include "backends/imgui_impl_sdlrenderer2.h"
 #include <SDL.h>
 #include <stdexcept>
+#include <algorithm>
+#include <utility>
 #include "core/rule_registry.hpp"
 #include "convex_hull/convex_hull.hpp"
+#include "aditional_rules/edge_detection.hpp"
+#include "aditional_rules/morphology.hpp"
 #include <filesystem>
 #include "core/io.hpp"
 #include <iostream>
@@ -88,6 +92,12 @@ bool Renderer::render() {
   engine_.setSpeed(speed_from_slider_);
   iteration_ = engine_.getIteration();
 
+  // Idle while paused: let the engine compute the next generations ahead of the next Step
+  if (paused_ && !engine_.isRunning()) {
+    engine_.speculate();
+  }
+  IO::instance().tickAutosave(engine_);
+
   return true;
 }
 
@@ -130,10 +140,64 @@ void Renderer::renderControls() {
 
     ImGui::Text("Iteration: %zu", iteration_);
 
+    if (auto converged = engine_.getConvergedIteration()) {
+      ImGui::Text("Converged at iteration %zu", *converged);
+    }
+
+    bool stop_on_convergence = engine_.isStoppingOnConvergence();
+    if (ImGui::Checkbox("Stop when converged", &stop_on_convergence)) {
+      engine_.setStopOnConvergence(stop_on_convergence);
+    }
+
+    if (auto cycle = engine_.getCycle()) {
+      if (cycle->period == 1) {
+        ImGui::Text("Fixed point since iteration %zu", cycle->start);
+      } else {
+        ImGui::Text("Cycle of period %zu since iteration %zu", cycle->period, cycle->start);
+      }
+    } else if (iteration_ > 0) {
+      ImGui::Text("Changed cells: %zu", engine_.getLastChangeCount());
+    }
+
+    if (paused_) {
+      if (const std::size_t ahead = engine_.getSpeculatedCount(); ahead > 0) {
+        ImGui::Text("Precomputed generations: %zu", ahead);
+      }
+    }
+
+    bool stop_on_cycle = engine_.isStoppingOnCycle();
+    if (ImGui::Checkbox("Stop on fixed point / cycle", &stop_on_cycle)) {
+      engine_.setStopOnCycle(stop_on_cycle);
+    }
+
     ImGui::Text("Iterations per Step");
     ImGui::InputScalar("##step_iters", ImGuiDataType_U32, &iterations_per_step_);
+    ImGui::Checkbox("Record every stepped generation", &record_every_step_);
+
+    bool max_throughput = engine_.isMaxThroughput();
+    bool skip_history = engine_.isSkippingHistory();
 
+    if (max_throughput) ImGui::BeginDisabled();
     ImGui::SliderFloat("Speed", &speed_from_slider_, 0.0f, 100.0f, "%.1f");
+    if (max_throughput) ImGui::EndDisabled();
+
+    // Steps as fast as the rule allows, the grid still refreshes at display rate
+    if (ImGui::Checkbox("Max throughput", &max_throughput)) {
+      engine_.setMaxThroughput(max_throughput, skip_history);
+    }
+
+    ImGui::SameLine();
+
+    if (!max_throughput) ImGui::BeginDisabled();
+    if (ImGui::Checkbox("Skip history frames", &skip_history)) {
+      engine_.setMaxThroughput(max_throughput, skip_history);
+    }
+    if (!max_throughput) ImGui::EndDisabled();
+
+    // The engine stops by itself once the rule converges or the run cycles (when asked to)
+    if (!paused_ && !engine_.isRunning()) {
+      paused_ = true;
+    }
 
     if (ImGui::Button(paused_ ? "Start" : "Pause")) {
       engine_.toggleRunning();
@@ -143,10 +207,11 @@ void Renderer::renderControls() {
     ImGui::SameLine();
 
     if (paused_ && ImGui::Button("Step")) {
-      // Manual stepping can batch multiple generations
-      for (std::size_t i = 0; i < iterations_per_step_; ++i) {
-        engine_.step();
-      }
+      // Batches run on the engine's thread so long ones don't freeze the UI; Pause cancels them
+      StepOptions options;
+      options.record_all = record_every_step_;
+      step_job_ = engine_.stepAsync(iterations_per_step_, options);
+      paused_ = false;
 
     } else if (!paused_) {
       ImGui::BeginDisabled();
@@ -166,6 +231,19 @@ void Renderer::renderControls() {
 
     ImGui::SameLine();
 
+    // Same amount of generations as Step but in one call, rules with a shortcut skip the per-generation passes
+    if (paused_ && ImGui::Button("Fast Forward")) {
+      engine_.fastForward(iterations_per_step_);
+    } else if (!paused_) {
+      ImGui::BeginDisabled();
+      ImGui::Button("Fast Forward");
+      ImGui::EndDisabled();
+    }
+
+    if (!step_job_.isFinished()) {
+      ImGui::ProgressBar(step_job_.getProgress(), ImVec2(-1.0f, 0.0f));
+    }
+
     if (ImGui::Button("Reset")) {
       paused_ = true;
       engine_.reset();
@@ -197,6 +275,7 @@ void Renderer::renderControls() {
     renderNeighborhoodSettings();
     renderBoundarySettings();
     renderRuleSettings();
+    renderHistorySettings();
 
     ImGui::Separator();
 
@@ -206,12 +285,9 @@ void Renderer::renderControls() {
   ImGui::EndChild();
 }
 
-// Neighborhood dropdown locked while simulation is running
+// Neighborhood dropdown (a change made while running applies from the next generation)
 void Renderer::renderNeighborhoodSettings() {
   const char* current_neighborhood = neighborhoodToString(neighborhood_);
-  const bool disable = !paused_;
-
-  if (disable) ImGui::BeginDisabled();
 
   const bool open = ImGui::BeginCombo("Neighborhood", current_neighborhood);
   if (open) {
@@ -220,7 +296,7 @@ void Renderer::renderNeighborhoodSettings() {
 
       if (ImGui::Selectable(neighborhoodToString(static_cast<Neighborhood>(n)), is_selected)) {
         neighborhood_ = static_cast<Neighborhood>(n);
-        engine_.setNeighborhood(neighborhood_);
+        engine_.post(NeighborhoodChange{neighborhood_});
       }
 
       if (is_selected) ImGui::SetItemDefaultFocus();
@@ -228,8 +304,6 @@ void Renderer::renderNeighborhoodSettings() {
 
     ImGui::EndCombo();
   }
-
-  if (disable) ImGui::EndDisabled();
 }
 
 // Rule dropdown + rule-specific setup
@@ -251,19 +325,15 @@ void Renderer::renderRuleSettings() {
         engine_.setRule(RuleRegistry::getInstance().make(rule_entry.key));
 
         if (rule_entry.key == CONVEX_HULL_RULE_NAME) {
-          // Convex hull needs distance bits prepared before stepping
-          engine_.setCalculatingDistances(true);
-          engine_.setDistanceCalculator(ConvexHull::calculateDistances);
-
           // Existing seeds become origins for distance propagation
           for (auto& cell : engine_.getGrid().getGridValues()) {
             if (is_seed(cell)) {
               cell = mark_origin(cell); 
             }
           }
+          engine_.refreshSnapshot();
         } else {
           // Other rules should not inherit convex-hull helper bits
-          engine_.setCalculatingDistances(false);
           engine_.resetDistances();
         }
       }
@@ -274,15 +344,44 @@ void Renderer::renderRuleSettings() {
     ImGui::EndCombo();
   }
 
+  // Edge detection can check its fast forward against plain stepping
+  if (auto* edge_rule = dynamic_cast<EdgeDetectionRule*>(&engine_.getRule())) {
+    bool verify = edge_rule->isVerifyingFastForward();
+    if (ImGui::Checkbox("Verify fast forward", &verify)) {
+      engine_.stopSpeculation();
+      edge_rule->setVerifyFastForward(verify);
+    }
+    if (const std::size_t mismatches = edge_rule->getFastForwardMismatches()) {
+      ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Fast forward differed from stepping %zu times (stepped state kept)", mismatches);
+    }
+  }
+
+  // Seed edits on a computed hull are replayed incrementally, this also recomputes from scratch to compare
+  if (engine_.getRule().getName() == CONVEX_HULL_RULE_NAME) {
+    bool verify = engine_.isVerifyingInputEdits();
+    if (ImGui::Checkbox("Verify seed edits", &verify)) {
+      engine_.setVerifyInputEdits(verify);
+    }
+    if (const std::size_t mismatches = engine_.getInputEditMismatches()) {
+      ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Seed edits differed from recomputing %zu times (recomputed state kept)", mismatches);
+    }
+  }
+
+  // k-step morphology: how many erosion/dilation steps one generation does
+  if (auto* morphology_rule = dynamic_cast<MorphologyRule*>(&engine_.getRule())) {
+    int iterations = static_cast<int>(morphology_rule->getIterations());
+    if (ImGui::InputInt("Steps per generation", &iterations)) {
+      // Changes what the next generations are, so it goes through the engine like a rule change
+      engine_.setRuleParameters(std::to_string(std::max(iterations, 1)));
+    }
+  }
+
   if (disable) ImGui::EndDisabled();
 }
 
-// Boundary dropdown locked while running
+// Boundary dropdown (a change made while running applies from the next generation)
 void Renderer::renderBoundarySettings() {
   const char* current_boundary = boundaryToString(boundary_);
-  const bool disable = !paused_;
-
-  if (disable) ImGui::BeginDisabled();
 
   const bool open = ImGui::BeginCombo("Boundary", current_boundary);
   if (open) {
@@ -291,7 +390,7 @@ void Renderer::renderBoundarySettings() {
 
       if (ImGui::Selectable(boundaryToString(static_cast<Boundary>(b)), is_selected)) {
         boundary_ = static_cast<Boundary>(b);
-        engine_.setBoundary(boundary_);
+        engine_.post(BoundaryChange{boundary_});
       }
 
       if (is_selected) ImGui::SetItemDefaultFocus();
@@ -299,8 +398,57 @@ void Renderer::renderBoundarySettings() {
 
     ImGui::EndCombo();
   }
+}
+
+// History storage: what gets recorded, memory use and budget
+void Renderer::renderHistorySettings() {
+  const HistoryMode mode = engine_.getHistoryMode();
+  const bool disable = !paused_;
+
+  if (disable) ImGui::BeginDisabled();
+
+  const bool open = ImGui::BeginCombo("History", historyModeToString(mode));
+  if (open) {
+    for (int m = 0; m < static_cast<int>(HistoryMode::Count); ++m) {
+      bool is_selected = (mode == static_cast<HistoryMode>(m));
+
+      if (ImGui::Selectable(historyModeToString(static_cast<HistoryMode>(m)), is_selected)) {
+        history_mode_refused_ = !engine_.setHistoryMode(static_cast<HistoryMode>(m), checkpoint_interval_);
+      }
+
+      if (is_selected) ImGui::SetItemDefaultFocus();
+    }
+
+    ImGui::EndCombo();
+  }
+
+  if (mode != HistoryMode::Full) {
+    // 0 lets the engine pick the interval from step time and budget
+    int interval = static_cast<int>(checkpoint_interval_);
+    if (ImGui::InputInt("Checkpoint interval (0 = auto)", &interval)) {
+      checkpoint_interval_ = static_cast<std::size_t>(std::max(interval, 0));
+      engine_.setHistoryMode(mode, checkpoint_interval_);
+    }
+    ImGui::Text("Checkpoint every %zu generations", engine_.getCheckpointInterval());
+  }
 
   if (disable) ImGui::EndDisabled();
+
+  if (history_mode_refused_) {
+    ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "This rule can't be replayed, history keeps every generation");
+  }
+
+  const HistoryStats history = engine_.getHistoryStats();
+  ImGui::Text("History: %.2f MB in memory, %.2f MB spilled", history.resident_bytes / (1024.0 * 1024.0), history.spilled_bytes / (1024.0 * 1024.0));
+  if (history.page_ins > 0) {
+    ImGui::Text("History page-ins: %zu", history.page_ins);
+  }
+
+  // Older generations go to a scratch file beyond this (0 = keep everything in memory)
+  int history_budget_mb = static_cast<int>(engine_.getHistoryBudget() >> 20);
+  if (ImGui::InputInt("History budget (MB)", &history_budget_mb)) {
+    engine_.setHistoryBudget(static_cast<std::size_t>(std::max(history_budget_mb, 0)) << 20);
+  }
 }
 
 // Grid display/edit settings
@@ -326,24 +474,81 @@ void Renderer::renderGridSettings() {
     grid_rows_ = pending_rows; 
     grid_cols_ = pending_cols;
     engine_.resizeGrid(grid_cols_, grid_rows_);
+    has_selection_ = false;
   } else if (!paused_) {
     ImGui::BeginDisabled();
     ImGui::Button("Apply Size");
     ImGui::EndDisabled();
   }
 
+  // Reshapes start a new run from the reshaped grid, like a resize
+  bool reshaped = false;
+  if (!paused_) ImGui::BeginDisabled();
+  if (ImGui::Button("Rotate Left")) {
+    engine_.transformGrid(GridTransform::RotateCounterclockwise);
+    reshaped = true;
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Rotate Right")) {
+    engine_.transformGrid(GridTransform::RotateClockwise);
+    reshaped = true;
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Rotate 180")) {
+    engine_.transformGrid(GridTransform::Rotate180);
+    reshaped = true;
+  }
+  if (ImGui::Button("Flip Horizontal")) {
+    engine_.transformGrid(GridTransform::FlipHorizontal);
+    reshaped = true;
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Flip Vertical")) {
+    engine_.transformGrid(GridTransform::FlipVertical);
+    reshaped = true;
+  }
+
+  ImGui::InputInt("Pad cells", &pad_cells_);
+  pad_cells_ = std::max(0, pad_cells_);
+  if (ImGui::Button("Pad")) {
+    const auto cells = static_cast<std::size_t>(pad_cells_);
+    engine_.padGrid(cells, cells, cells, cells);
+    reshaped = true;
+  }
+  ImGui::SameLine();
+  if (!has_selection_) ImGui::BeginDisabled();
+  if (ImGui::Button("Crop to Selection")) {
+    engine_.cropGrid(std::min(selection_x0_, selection_x1_), std::min(selection_y0_, selection_y1_),
+                     std::max(selection_x0_, selection_x1_) - std::min(selection_x0_, selection_x1_) + 1,
+                     std::max(selection_y0_, selection_y1_) - std::min(selection_y0_, selection_y1_) + 1);
+    reshaped = true;
+  }
+  if (!has_selection_) ImGui::EndDisabled();
+  if (!paused_) ImGui::EndDisabled();
+
+  // The dimensions shown follow the reshaped grid, the old selection no longer lines up with it
+  if (reshaped) {
+    const std::shared_ptr<const GridSnapshot> snapshot = engine_.getSnapshot();
+    grid_cols_ = snapshot->width;
+    grid_rows_ = snapshot->height;
+    pending_cols = static_cast<int>(grid_cols_);
+    pending_rows = static_cast<int>(grid_rows_);
+    has_selection_ = false;
+  }
+
+  ImGui::Text("Right drag selects, Ctrl+C copies the selection, Ctrl+V pastes at the hovered cell");
+
   ImGui::Text("Mouse over cell: (%zu, %zu)", hovered_cell_x_, hovered_cell_y_);
 }
 
 // Draws grid and handles paused editing
 void Renderer::renderGrid() {
-  Grid& grid = engine_.getGrid();
+  // Published generation: consistent even while the worker steps, and nothing is copied or locked to draw it
+  const std::shared_ptr<const GridSnapshot> snapshot = engine_.getSnapshot();
+  const std::vector<uint8_t>& cells = snapshot->cells;
 
-  std::size_t rows = grid.getGridValues().size() / grid.getWidth();
-  std::size_t cols = grid.getWidth();
-
-  // Local copy avoids drawing while grid mutates underneath
-  std::vector<uint8_t> cells = grid.getGridValues();
+  std::size_t rows = snapshot->height;
+  std::size_t cols = snapshot->width;
 
   const float cellSize = cell_size_ * zoom_;
   const float grid_w = cols * cellSize;
@@ -399,6 +604,15 @@ void Renderer::renderGrid() {
       }
     }
     
+    if (has_selection_ || selecting_) {
+      const std::size_t x0 = std::min(selection_x0_, selection_x1_);
+      const std::size_t y0 = std::min(selection_y0_, selection_y1_);
+      const std::size_t x1 = std::max(selection_x0_, selection_x1_) + 1;
+      const std::size_t y1 = std::max(selection_y0_, selection_y1_) + 1;
+      dl->AddRect(ImVec2(p0.x + x0 * cellSize, p0.y + y0 * cellSize), ImVec2(p0.x + x1 * cellSize, p0.y + y1 * cellSize),
+                  IM_COL32(80, 160, 255, 255), 0.0f, 0, 2.0f);
+    }
+
     if (show_grid_) {
         for (std::size_t c = 1; c < cols; ++c) {
             float x = p0.x + c * cellSize;
@@ -413,8 +627,10 @@ void Renderer::renderGrid() {
         }
     }
 
-    // Editing is disabled while simulation thread may be writing
-    if ((hovered || active) && paused_) {
+    // Paints are posted to the engine, which applies them between generations while it runs
+    // Convex Hull seeds are only edited while paused (the engine updates just what they affect)
+    const bool can_edit = paused_ || engine_.getRule().getName() != CONVEX_HULL_RULE_NAME;
+    if ((hovered || active) && can_edit) {
       ImVec2 mp = ImGui::GetIO().MousePos;
       int col = (int)((mp.x - p0.x) / cellSize);
       int row = (int)((mp.y - p0.y) / cellSize);
@@ -425,23 +641,58 @@ void Renderer::renderGrid() {
       if (col >= 0 && col < (int)cols && row >= 0 && row < (int)rows) {
         int idx = row * cols + col;
 
+        // Convex Hull already computed: edit the input seeds and let the engine update only what they affect
+        const bool edit_input = paused_ && engine_.getIteration() > 0 && engine_.getRule().getName() == CONVEX_HULL_RULE_NAME;
+
+        if (edit_input) {
+          const uint8_t seed = mark_origin(create_cell(true, false, 0));
+          const uint8_t input = engine_.getStateAtIteration(0)[idx];
+
+          if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+            engine_.editInput({{static_cast<std::size_t>(col), static_cast<std::size_t>(row), is_seed(input) ? uint8_t{0} : seed}});
+          } else if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+            const uint8_t wanted = ImGui::GetIO().KeyShift ? uint8_t{0} : seed;
+            if (input != wanted) {
+              engine_.editInput({{static_cast<std::size_t>(col), static_cast<std::size_t>(row), wanted}});
+            }
+          }
+        }
+
+        // Right drag selects a block, Ctrl+C copies it and Ctrl+V stamps the copy with its top left corner here
+        if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
+          selecting_ = true;
+          selection_x0_ = selection_x1_ = static_cast<std::size_t>(col);
+          selection_y0_ = selection_y1_ = static_cast<std::size_t>(row);
+        } else if (selecting_ && ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
+          selection_x1_ = static_cast<std::size_t>(col);
+          selection_y1_ = static_cast<std::size_t>(row);
+        }
+
+        if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_C, false) && has_selection_) {
+          clipboard_width_ = std::max(selection_x0_, selection_x1_) - std::min(selection_x0_, selection_x1_) + 1;
+          clipboard_ = engine_.copyRegion(std::min(selection_x0_, selection_x1_), std::min(selection_y0_, selection_y1_), clipboard_width_,
+                                          std::max(selection_y0_, selection_y1_) - std::min(selection_y0_, selection_y1_) + 1);
+        }
+        if (!edit_input && ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_V, false) && !clipboard_.empty()) {
+          engine_.post(PatternStamp{static_cast<std::size_t>(col), static_cast<std::size_t>(row), clipboard_width_, clipboard_});
+        }
+
+        uint8_t value = cells[idx];
+
         // Click toggles current cell
-        if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-          cells[idx] ^= 1u;
-          grid.setCell(col, row, cells[idx]);
+        if (!edit_input && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+          value ^= 1u;
         }
 
         // Drag paints, Shift+drag erases
-        if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        if (!edit_input && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
           bool erase = ImGui::GetIO().KeyShift;
-          uint8_t newVal = erase ? 0u : 1u;
-
-          if (cells[idx] != newVal) {
-            cells[idx] = newVal;
-            grid.setCell(col, row, cells[idx]);
-          }
+          value = erase ? 0u : 1u;
         }
 
+        // The snapshot being drawn is immutable, edits show up once the engine republishes
+        if (value != cells[idx]) engine_.post(CellEdit{static_cast<std::size_t>(col), static_cast<std::size_t>(row), value});
+
         // Lightweight hover feedback
         ImVec2 a(p0.x + col * cellSize + 1,       p0.y + row * cellSize + 1);
         ImVec2 b(p0.x + (col + 1) * cellSize - 1, p0.y + (row + 1) * cellSize - 1);
@@ -450,12 +701,19 @@ void Renderer::renderGrid() {
     }
   }
 
+  if (selecting_ && !ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
+    selecting_ = false;
+    has_selection_ = true;
+  }
+
   ImGui::EndChild();
   ImGui::PopStyleVar();
 }
 
 // Cleans up UI + SDL resources
 Renderer::~Renderer() {
+  // Save callbacks point back here
+  IO::instance().waitForSaves();
   tearDownImGui();
 }
 
@@ -537,6 +795,18 @@ void Renderer::renderAbout() {
 void Renderer::renderExportImportButtons() {
   ImGui::Text("Save/Load Grid:");
 
+  if (save_failed_.exchange(false)) {
+    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
+                             "Save Error",
+                             "Failed to save the grid to file.",
+                             window_);
+  }
+
+  double autosave_seconds = IO::instance().getAutosaveInterval();
+  if (ImGui::InputDouble("Autosave (s, 0 = off)", &autosave_seconds, 10.0, 60.0, "%.0f")) {
+    IO::instance().setAutosaveInterval(autosave_seconds);
+  }
+
   if (paused_ && ImGui::Button("Save Grid")) {
     ImGui::OpenPopup("Save Grid");
   }
@@ -546,18 +816,20 @@ void Renderer::renderExportImportButtons() {
     static bool use_default_save_folder = true;
 
     ImGui::InputText("Filename", save_filename, IM_ARRAYSIZE(save_filename));
+    ImGui::TextDisabled("A .cas filename saves a compact binary snapshot, .rle/.cells/.mc a pattern file");
     ImGui::Checkbox("Use Default Save Folder", &use_default_save_folder);
 
+    bool compact_json = IO::instance().isCompactJson();
+    if (ImGui::Checkbox("Compact JSON", &compact_json)) {
+      IO::instance().setCompactJson(compact_json);
+    }
+
     if (ImGui::Button("Save")) {
-      bool success = IO::instance().saveGridToFile(engine_, std::string(save_filename), use_default_save_folder);
+      // Written on the IO thread, a failure is reported on a later frame
+      IO::instance().saveGridToFileAsync(engine_, std::string(save_filename), use_default_save_folder, [this](bool success) {
+        if (!success) save_failed_.store(true);
+      });
       ImGui::CloseCurrentPopup();
-
-      if (!success) {
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
-                                 "Save Error",
-                                 "Failed to save the grid to file.",
-                                 window_);
-      }
     }
 
     ImGui::SameLine();
@@ -592,6 +864,68 @@ void Renderer::renderExportImportButtons() {
 
     ImGui::SameLine();
 
+    if (ImGui::Button("Load Autosave")) {
+      IO::instance().waitForSaves();
+      bool success = IO::instance().loadAutosave(engine_);
+      ImGui::CloseCurrentPopup();
+
+      if (!success) {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
+                                 "Load Error",
+                                 "Failed to load the autosave.",
+                                 window_);
+      }
+    }
+
+    ImGui::SameLine();
+
+    if (ImGui::Button("Cancel")) {
+      ImGui::CloseCurrentPopup();
+    }
+
+    ImGui::EndPopup();
+  }
+
+  // Recording of the run from the current generation on, written in the background while it steps
+  if (engine_.isRecording()) {
+    ImGui::Text("Recording: %zu generations, %.1f MB", engine_.getRecordedGenerations(),
+                static_cast<double>(engine_.getRecordingBytes()) / (1024.0 * 1024.0));
+    if (ImGui::Button("Stop Recording") && !engine_.stopRecording()) {
+      SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
+                               "Recording Error",
+                               "Failed to write the recording file.",
+                               window_);
+    }
+  } else if (ImGui::Button("Record Run")) {
+    ImGui::OpenPopup("Record Run");
+  }
+
+  if (ImGui::BeginPopup("Record Run")) {
+    static char record_filename[128] = "run.carec";
+
+    ImGui::InputText("Filename", record_filename, IM_ARRAYSIZE(record_filename));
+    ImGui::TextDisabled("Saved in the default save folder");
+
+    if (ImGui::Button("Record")) {
+      bool success = false;
+      try {
+        std::filesystem::create_directories(DEFAULT_SAVE_FOLDER);
+        success = engine_.startRecording(DEFAULT_SAVE_FOLDER + record_filename);
+      } catch (const std::exception& e) {
+        success = false;
+      }
+      ImGui::CloseCurrentPopup();
+
+      if (!success) {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
+                                 "Recording Error",
+                                 "Failed to create the recording file.",
+                                 window_);
+      }
+    }
+
+    ImGui::SameLine();
+
     if (ImGui::Button("Cancel")) {
       ImGui::CloseCurrentPopup();
     }
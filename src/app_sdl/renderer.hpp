@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include "core/engine.hpp"
 #include <SDL.h>
@@ -37,6 +38,8 @@ private:
 
   std::size_t iteration_; // cached from engine 
   std::size_t iterations_per_step_; // allows stepping multiple times per frame
+  bool record_every_step_ = true;   // false: a Step batch only records its last generation
+  StepHandle step_job_;             // last Step batch (runs on the engine's thread)
 
   std::size_t grid_rows_;
   std::size_t grid_cols_;
@@ -47,6 +50,22 @@ private:
   std::size_t hovered_cell_x_; // for interaction/debug
   std::size_t hovered_cell_y_;
 
+  // Block selected by dragging with the right mouse button (corners as dragged), and the cells last copied from one
+  bool selecting_ = false;
+  bool has_selection_ = false;
+  std::size_t selection_x0_ = 0;
+  std::size_t selection_y0_ = 0;
+  std::size_t selection_x1_ = 0;
+  std::size_t selection_y1_ = 0;
+  std::vector<uint8_t> clipboard_;
+  std::size_t clipboard_width_ = 0;
+  int pad_cells_ = 1; // added on every side by Pad
+
+  std::size_t checkpoint_interval_ = 0; // sparse history interval asked for (0 = automatic)
+  bool history_mode_refused_ = false;   // last history mode change was refused by the rule
+
+  std::atomic<bool> save_failed_ = false; // set by a background save, reported on the next frame
+
   // Raw SDL handles (manual lifetime management)
   SDL_Window* window_ = nullptr;
   SDL_Renderer* sdl_renderer_ = nullptr;
@@ -59,6 +78,7 @@ private:
   void renderNeighborhoodSettings();
   void renderBoundarySettings();
   void renderRuleSettings();
+  void renderHistorySettings();
   void renderCustomRuleEditor(); 
   void renderAbout();
 
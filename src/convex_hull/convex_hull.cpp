@@ -1,57 +1,121 @@
 #include "convex_hull.hpp"
+#include "hull_oracle.hpp"
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t FIRST_COLUMN = 0x108421; // bits of dx = -2 in every window row
+constexpr uint32_t LAST_COLUMN = FIRST_COLUMN << (DistanceWindow::SIDE - 1);
+
+// Neighborhood of every cell in the 3x3 around the window center, indexed [neighborhood][(dy + 1) * 3 + dx + 1]
+template <std::size_t N>
+constexpr std::array<uint32_t, 9> neighbourhood_masks(const std::array<std::pair<int,int>, N>& deltas) {
+  std::array<uint32_t, 9> masks{};
+  for (int dy = -1; dy <= 1; ++dy) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (const auto& delta : deltas) {
+        masks[(dy + 1) * 3 + dx + 1] |= DistanceWindow::bit(dx + delta.first, dy + delta.second);
+      }
+    }
+  }
+  return masks;
+}
 
-// Checks if two same-distance neighbor regions are disconnected
-bool ConvexHull::distinct_sets(const RuleContext& ctx, std::size_t nx, std::size_t ny, std::size_t main_index, std::size_t second_index, uint8_t goal_distance) const {
-  auto all_coords_to_check = ctx.getEdgeNeighborhoodWithCoordinates(ctx.x, ctx.y, nx, ny);
-  auto deltas = pick_deltas(ctx.neighborhood);
+constexpr std::array<std::array<uint32_t, 9>, 2> NEIGHBOURHOOD_MASKS = {
+  neighbourhood_masks(deltas_moore), neighbourhood_masks(deltas_vonneumann)
+};
 
-  auto out_of_bounds = [&](int x, int y) {
-    return (x < 0 || y < 0 || x >= static_cast<int>(ctx.getGrid().getWidth()) || y >= static_cast<int>(ctx.getGrid().getHeight()));
-  };
+uint32_t neighbourhood_mask(Neighborhood neighborhood, int dx, int dy) {
+  return NEIGHBOURHOOD_MASKS[neighborhood == Neighborhood::Moore ? 0 : 1][(dy + 1) * 3 + dx + 1];
+}
 
-  std::vector<std::pair<int,int>> to_visit;
-  std::vector<std::pair<int,int>> visited;
+// Adds every cell one step away (in the given neighborhood) to the mask
+uint32_t grow(uint32_t mask, Neighborhood neighborhood) {
+  const uint32_t sideways = mask | ((mask << 1) & ~FIRST_COLUMN) | ((mask >> 1) & ~LAST_COLUMN);
+  if (neighborhood == Neighborhood::Moore) {
+    return (sideways | (sideways << DistanceWindow::SIDE) | (sideways >> DistanceWindow::SIDE)) & DistanceWindow::MASK;
+  }
+  return (sideways | (mask << DistanceWindow::SIDE) | (mask >> DistanceWindow::SIDE)) & DistanceWindow::MASK;
+}
 
-  std::pair<int,int> goal = {static_cast<int>(nx) + deltas[second_index].first, static_cast<int>(ny) + deltas[second_index].second};
-  to_visit.emplace_back(static_cast<int>(ctx.x) + deltas[main_index].first, static_cast<int>(ctx.y) + deltas[main_index].second);
+} // namespace
 
-  while (!to_visit.empty()) {
-    auto current = to_visit.back();
-    to_visit.pop_back();
+DistanceWindow::DistanceWindow(const std::vector<uint8_t>& cells, std::size_t width, std::size_t height, std::size_t x, std::size_t y,
+                               const std::vector<uint8_t>& neighbours)
+  : cells_(cells), width_(width), height_(height), x_(x), y_(y) {
+  for (std::size_t i = 0; i < neighbours.size(); ++i) {
+    neighbours_with_distance_[get_distance(neighbours[i])] |= 1u << i;
+    next_to_center_ |= is_center_cell(neighbours[i]) || is_unused_center_cell(neighbours[i]);
+  }
+  all_neighbours_ = (1u << neighbours.size()) - 1;
+}
 
-    if (std::find(visited.begin(), visited.end(), current) != visited.end()) {
-      continue;
-    }
+void DistanceWindow::load() {
+  // Low/high bit of the raw 2-bit distance for every cell of the block, raw 3 counts as 0 (see get_distance)
+  uint32_t low = 0;
+  uint32_t high = 0;
+  uint32_t present = 0;
 
-    visited.push_back(current);
+  auto add = [&](uint8_t state, uint32_t bit) {
+    low |= ((state >> CellBits::DIST_SHIFT) & 1u) ? bit : 0u;
+    high |= ((state >> (CellBits::DIST_SHIFT + 1)) & 1u) ? bit : 0u;
+  };
 
-    if (current == goal) {
-      return false; // connected → not distinct sets
+  if (x_ >= 2 && y_ >= 2 && x_ + 2 < width_ && y_ + 2 < height_) {
+    const uint8_t* row = cells_.data() + idx(x_ - 2, y_ - 2, width_);
+    uint32_t bit = 1;
+    for (int dy = 0; dy < SIDE; ++dy, row += width_) {
+      for (int dx = 0; dx < SIDE; ++dx, bit <<= 1) {
+        add(row[dx], bit);
+      }
     }
+    present = MASK;
+  } else {
+    for (int dy = -2; dy <= 2; ++dy) {
+      for (int dx = -2; dx <= 2; ++dx) {
+        const long cx = static_cast<long>(x_) + dx;
+        const long cy = static_cast<long>(y_) + dy;
+        if (cx < 0 || cy < 0 || cx >= static_cast<long>(width_) || cy >= static_cast<long>(height_)) {
+          continue;
+        }
 
-    auto neighbors = ctx.getNeighborhoodWithCoordinates(static_cast<std::size_t>(current.first), static_cast<std::size_t>(current.second));
-
-    for (const auto& neighbor : neighbors) {
-      if (out_of_bounds(neighbor.first, neighbor.second)) {
-        continue;
+        add(cells_[idx(cx, cy, width_)], bit(dx, dy));
+        present |= bit(dx, dy);
       }
+    }
+  }
 
-      // Search is limited to the two local neighborhoods only
-      if (std::find(all_coords_to_check.begin(), all_coords_to_check.end(), neighbor) == all_coords_to_check.end()) {
-        continue;
-      }
+  with_distance_[0] = present & ~(low ^ high);
+  with_distance_[1] = low & ~high;
+  with_distance_[2] = high & ~low;
+  loaded_ = true;
+}
 
-      uint8_t neighbor_state = ctx.getGrid().getGridValues()[neighbor.second * ctx.getGrid().getWidth() + neighbor.first];
-      if (get_distance(neighbor_state) == goal_distance) {
-        to_visit.push_back(neighbor);
-      }
+// Checks if two same-distance neighbor regions are disconnected
+// Flood fill from the first cell through same-distance cells of both neighborhoods, done on whole masks at once
+bool ConvexHull::distinct_sets(DistanceWindow& window, Neighborhood neighborhood, int nx, int ny, std::size_t main_index, std::size_t second_index, uint8_t goal_distance) const {
+  const auto deltas = pick_deltas(neighborhood);
+
+  const uint32_t start = DistanceWindow::bit(deltas[main_index].first, deltas[main_index].second);
+  const uint32_t goal = DistanceWindow::bit(nx + deltas[second_index].first, ny + deltas[second_index].second);
+
+  // Search is limited to the two local neighborhoods only
+  const uint32_t allowed = ((neighbourhood_mask(neighborhood, 0, 0) | neighbourhood_mask(neighborhood, nx, ny)) & window.withDistance(goal_distance)) | start;
+
+  uint32_t reached = start;
+  while ((reached & goal) == 0) {
+    const uint32_t next = grow(reached, neighborhood) & allowed;
+    if (next == reached) {
+      return true; // no path found → distinct sets
     }
+    reached = next;
   }
 
-  return true; // no path found → distinct sets
+  return false; // connected → not distinct sets
 }
 
 // Main convex hull rule step
@@ -69,14 +133,19 @@ uint8_t ConvexHull::apply(uint8_t current_state, const RuleContext& ctx, const s
     return create_cell(false, false, 0);
   }
 
+  return find_hull(current_state, ctx, neighbours);
+}
+
+uint8_t ConvexHull::find_hull(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
   bool mark = false;
+  DistanceWindow window(ctx.getGrid().getGridValues(), ctx.getGrid().getWidth(), ctx.getGrid().getHeight(), ctx.x, ctx.y, neighbours);
 
-  current_state = vertex_center(current_state, ctx, neighbours);
+  current_state = vertex_center(current_state, ctx, neighbours, window);
   if (is_marked(current_state)) {
     return current_state;
   }
 
-  current_state = edge_center(current_state, ctx, neighbours);
+  current_state = edge_center(current_state, ctx, neighbours, window);
   if (is_marked(current_state)) {
     return current_state;
   }
@@ -93,66 +162,39 @@ uint8_t ConvexHull::apply(uint8_t current_state, std::vector<uint8_t> neighbours
 }
 
 // Updates distance wavefronts from seed cells
-void ConvexHull::calculateDistances(std::vector<uint8_t>& grid, std::size_t width, std::size_t height, Neighborhood neighborhood, Boundary boundary) {
-  std::vector<uint8_t> old_grid = grid; // snapshot keeps distance update simultaneous
-  std::vector<uint8_t> neighbors;
-  neighbors.reserve(8); // TODO: not always 8 for every neighborhood
-
-  for (std::size_t y = 0; y < height; ++y) {
-    for (std::size_t x = 0; x < width; ++x) {
-      if (is_seed(old_grid[y * width + x])) {
-        continue; // seeds are distance sources
-      }
-
-      neighbors.clear();
-      Grid::getNeighborsStatic(old_grid, x, y, width, height, neighborhood, boundary, neighbors);
-
-      bool all_same = true;
-      uint8_t distance = get_distance(grid[y * width + x]); 
-
-      for (uint8_t neighbor : neighbors) {
-        if (get_distance(neighbor) != distance) {
-          all_same = false;
-          break;
-        } 
-      }
+uint8_t ConvexHull::preStep(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
+  if (is_seed(current_state)) {
+    return current_state; // seeds are distance sources
+  }
 
-      // Only advance cells whose neighborhood has caught up
-      if (all_same) { 
-        grid[y * width + x] = advance_distance(grid[y * width + x]);
-      }
+  // Only advance cells whose neighborhood has caught up
+  const uint8_t distance = get_distance(current_state);
+  for (uint8_t neighbor : neighbours) {
+    if (get_distance(neighbor) != distance) {
+      return current_state;
     }
   }
+
+  return advance_distance(current_state);
 }
 
 // Detects a vertex-like center where opposite same-distance fronts meet
-uint8_t ConvexHull::vertex_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
+uint8_t ConvexHull::vertex_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours, DistanceWindow& window) const {
   if (ctx.x == 0 || ctx.y == 0 || ctx.x == ctx.getGrid().getWidth() - 1 || ctx.y == ctx.getGrid().getHeight() - 1) {
     return current_state;
   }
 
-  uint8_t dist_x = get_distance(current_state);
-  bool all_same = true;
-  bool potential_unused_center = false;
-
-  for (auto neighbour :neighbours) {
-    if (is_center_cell(neighbour) || is_unused_center_cell(neighbour)) {
-      potential_unused_center = true;
-    }
-
-    if (get_distance(neighbour) != dist_x) {
-      all_same = false;
-    }
-  }
-
-  if (all_same) dist_x = get_distance(advance_distance(current_state));
-
   uint8_t wanted_dist = get_distance(retreat_distance(current_state)); 
   std::size_t half_size = neighbours.size() / 2;
 
-  for (std::size_t i = 0; i < half_size; ++i) {
-    if ((get_distance(neighbours[i]) == wanted_dist && get_distance(neighbours[i + half_size]) == wanted_dist) && distinct_sets(ctx, ctx.x, ctx.y, i, i + half_size, wanted_dist)) {
-      if (potential_unused_center) {
+  // i such that both neighbours[i] and its opposite neighbours[i + half_size] have the wanted distance
+  const uint32_t wanted = window.neighboursWithDistance(wanted_dist);
+  const uint32_t pairs = wanted & (wanted >> half_size) & ((1u << half_size) - 1);
+
+  for (uint32_t rest = pairs; rest != 0; rest &= rest - 1) {
+    const std::size_t i = static_cast<std::size_t>(std::countr_zero(rest));
+    if (distinct_sets(window, ctx.neighborhood, 0, 0, i, i + half_size, wanted_dist)) {
+      if (window.nextToCenter()) {
         return mark_unused_center_cell(current_state);
       }
 
@@ -164,54 +206,40 @@ uint8_t ConvexHull::vertex_center(uint8_t current_state, const RuleContext& ctx,
 }
 
 // Detects center cells that lie between two adjacent same-distance cells
-uint8_t ConvexHull::edge_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
+uint8_t ConvexHull::edge_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours, DistanceWindow& window) const {
   // Avoid border math until boundary cases are handled cleanly
   if (ctx.x == 0 || ctx.y == 0 || ctx.x == ctx.getGrid().getWidth() - 1 || ctx.y == ctx.getGrid().getHeight() - 1 || ctx.x == 1 || ctx.y == 1 || ctx.x == ctx.getGrid().getWidth() - 2 || ctx.y == ctx.getGrid().getHeight() - 2) {
     return current_state;
   }
 
   uint8_t dist_x = get_distance(current_state);
+  uint8_t wanted_dist = get_distance(retreat_distance(current_state)); 
   auto deltas = pick_deltas(ctx.neighborhood);
-  bool potential_unused_center = false;
-  const auto& gridVals = ctx.getGrid().getGridValues();
+  const std::size_t half_size = neighbours.size() / 2;
 
-  for (auto neighbour :neighbours) {
-    if (is_center_cell(neighbour) || is_unused_center_cell(neighbour)) {
-      potential_unused_center = true;
-      break;
-    }
+  // j candidates: the neighbour opposite to j has the wanted distance (neighbor order matters: opposite index means opposite direction)
+  const uint32_t wanted = window.neighboursWithDistance(wanted_dist);
+  const uint32_t candidates = ((wanted >> half_size) | (wanted << half_size)) & window.allNeighbours();
+  if (candidates == 0) {
+    return current_state;
   }
-  
-  for (std::size_t i = 0; i < deltas.size(); ++i) {
-    int nx = static_cast<int>(ctx.x) + deltas[i].first;
-    int ny = static_cast<int>(ctx.y) + deltas[i].second;
-
-    if (nx < 0 || ny < 0 || nx >= static_cast<int>(ctx.getGrid().getWidth()) || ny >= static_cast<int>(ctx.getGrid().getHeight())) {
-      continue;
-    }
-
-    uint8_t neighbor_state = gridVals[ny * ctx.getGrid().getWidth() + nx];
-    uint8_t dist_y = get_distance(neighbor_state);
-
-    if (dist_y != dist_x) {
-      continue;
-    }
 
-    uint8_t wanted_dist = get_distance(retreat_distance(current_state)); 
-    auto y_neighbors = ctx.getNeighbors(static_cast<std::size_t>(nx), static_cast<std::size_t>(ny));
+  // second center: any neighbour with the same distance as this cell
+  for (uint32_t same = window.neighboursWithDistance(dist_x); same != 0; same &= same - 1) {
+    const std::size_t i = static_cast<std::size_t>(std::countr_zero(same));
+    const int nx = deltas[i].first;
+    const int ny = deltas[i].second;
 
-    // Neighbor order matters: opposite index means opposite direction
-    for (std::size_t j = 0; j < neighbours.size(); ++j) {
-      if (get_distance(y_neighbors[j]) == wanted_dist) {
-        std::size_t opposite_index = (j + (neighbours.size() / 2)) % neighbours.size();
+    for (uint32_t rest = candidates; rest != 0; rest &= rest - 1) {
+      const std::size_t j = static_cast<std::size_t>(std::countr_zero(rest));
+      const std::size_t opposite_index = j < half_size ? j + half_size : j - half_size;
 
-        if (get_distance(neighbours[opposite_index]) == wanted_dist && distinct_sets(ctx, nx, ny, opposite_index, j, wanted_dist)) {
-          if (potential_unused_center) {
-            return mark_unused_center_cell(current_state);
-          }
-
-          return mark_cell(mark_center_cell(current_state));
+      if (window.has(nx + deltas[j].first, ny + deltas[j].second, wanted_dist) && distinct_sets(window, ctx.neighborhood, nx, ny, opposite_index, j, wanted_dist)) {
+        if (window.nextToCenter()) {
+          return mark_unused_center_cell(current_state);
         }
+
+        return mark_cell(mark_center_cell(current_state));
       }
     }
   }
@@ -245,6 +273,44 @@ bool ConvexHull::exists_oposite_marked_neighbor(uint8_t current_state, const std
   return false;
 }
 
+bool ConvexHull::beginRun(const Grid& input) const {
+  oracle_ = hull_oracle::seed_hull(input.getGridValues(), input.getWidth(), input.getHeight(), input.getNeighborhood());
+  return false; // the oracle is only read by hasConverged, stepping doesn't change
+}
+
+bool ConvexHull::hasConverged(const Grid& grid) const {
+  // Only the end of a round counts: marks made mid-round can still be dropped by the reset
+  const std::size_t iteration = grid.getIteration();
+  if (iteration == 0 || iteration % grid.getWidth() != 0) {
+    return false;
+  }
+
+  // The next generation is a reset: converged if this round marked nothing
+  const auto& cells = grid.getGridValues();
+  if (std::none_of(cells.begin(), cells.end(), [](uint8_t s) { return is_marked(s) && !is_seed(s); })) {
+    return true;
+  }
+
+  if (oracle_.size() != cells.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < cells.size(); ++i) {
+    if ((is_seed(cells[i]) || is_marked(cells[i])) != (oracle_[i] != 0)) return false;
+  }
+  return true;
+}
+
+bool ConvexHull::requiresFullStep(const Grid& grid) const {
+  const std::size_t iteration = grid.getIteration();
+  return iteration % grid.getWidth() == 0 || (iteration - 1) % grid.getWidth() == 0;
+}
+
+std::size_t ConvexHull::timePhase(const Grid& grid) const {
+  const std::size_t iteration = grid.getIteration();
+  return iteration == 0 ? grid.getWidth() : iteration % grid.getWidth();
+}
+
 std::string ConvexHull::getName() const {
   return CONVEX_HULL_RULE_NAME;
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include "core/rule.hpp"
 #include "core/grid.hpp"
 #include "core/rule_registry.hpp"
@@ -77,6 +78,53 @@ inline constexpr uint8_t create_cell(bool seed, bool marked, uint8_t distance) {
   return set_distance(s, distance);
 }
 
+// Packed distance descriptor of one cell, used by edge/vertex center detection
+// - per distance value, a bitmask over the neighbour indices (built once from the neighbour list)
+// - per distance value, a 25-bit mask of the 5x5 block around the cell (bit (dy + 2) * 5 + dx + 2); the detection never
+//   looks more than two cells away, so the block is read at most once per cell (on first use, many cells never need it)
+// With these the pattern checks and the connectivity check in distinct_sets become a few mask operations
+class DistanceWindow {
+public:
+  static constexpr int SIDE = 5;
+  static constexpr uint32_t MASK = (1u << (SIDE * SIDE)) - 1;
+
+  DistanceWindow(const std::vector<uint8_t>& cells, std::size_t width, std::size_t height, std::size_t x, std::size_t y,
+                 const std::vector<uint8_t>& neighbours);
+
+  static constexpr uint32_t bit(int dx, int dy) { return 1u << ((dy + 2) * SIDE + dx + 2); }
+
+  // Neighbour indices (bit i = neighbours[i]) with this distance
+  uint32_t neighboursWithDistance(uint8_t distance) const { return neighbours_with_distance_[distance]; }
+  uint32_t allNeighbours() const { return all_neighbours_; }
+
+  // Some neighbour already is a (used or unused) center cell
+  bool nextToCenter() const { return next_to_center_; }
+
+  // Cells of the block with this distance (cells outside the grid are in none of the masks)
+  uint32_t withDistance(uint8_t distance) {
+    if (!loaded_) load();
+    return with_distance_[distance];
+  }
+
+  bool has(int dx, int dy, uint8_t distance) { return (withDistance(distance) & bit(dx, dy)) != 0; }
+
+private:
+  void load();
+
+  const std::vector<uint8_t>& cells_;
+  std::size_t width_;
+  std::size_t height_;
+  std::size_t x_;
+  std::size_t y_;
+
+  std::array<uint32_t, 3> neighbours_with_distance_{};
+  uint32_t all_neighbours_ = 0;
+  bool next_to_center_ = false;
+
+  bool loaded_ = false;
+  std::array<uint32_t, 3> with_distance_{};
+};
+
 // Registry name
 constexpr std::string CONVEX_HULL_RULE_NAME = "Convex Hull"; 
 
@@ -96,9 +144,32 @@ public:
 
   std::string getName() const override;
   
-  // Preprocessing step run outside normal CA step (Engine hook)
-  // Computes distance layers before rule logic kicks in
-  static void calculateDistances(std::vector<uint8_t>& grid, std::size_t width, std::size_t height, Neighborhood neighborhood, Boundary boundary);
+  // Distance wave runs as the first stage of every step (computes distance layers before rule logic kicks in)
+  bool hasPreStep() const override { return true; }
+  uint8_t preStep(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const override;
+
+  // Only the wavefront and the marked frontier move, so Grid::step can stay near them
+  // The distance wave reads direct neighbours, center detection looks up to two cells away
+  bool hasActiveBand() const override { return true; }
+  std::size_t preStepRadius() const override { return 1; }
+  std::size_t applyRadius() const override { return 2; }
+
+  // The periodic reset (iteration % width == 0) changes how every cell behaves, as does the generation right after it
+  bool requiresFullStep(const Grid& grid) const override;
+
+  // Position in the reset round, so repeating rounds are seen as a cycle of period width (iteration 0 never resets)
+  std::size_t timePhase(const Grid& grid) const override;
+
+  // Computes the geometric hull of the input seeds (hull_oracle) for hasConverged
+  bool beginRun(const Grid& input) const override;
+
+  // Checked at the end of a reset round only: converged when the round marked nothing new (the reset then brings back
+  // the same seeds, so every later round repeats this one), or when marked and seed cells are exactly the geometric
+  // hull of the input (the reset turns them into seeds, and on every save the CA stays on that hull)
+  bool hasConverged(const Grid& grid) const override;
+
+  // Geometric hull of the input seeds of the current run (1/0 per cell, empty before the first run)
+  const std::vector<uint8_t>& getOracle() const { return oracle_; }
 
   // Auto-register rule
   static inline AutoRegisterRule<ConvexHull> auto_register_convex_hull{
@@ -108,13 +179,16 @@ public:
 
 private:
   
+  // Hull search of one cell (everything apply does between resets)
+  uint8_t find_hull(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const;
+
   // all of these all from the book but I changed them a little bit
   
   // Detects edge centers (part of hull construction)
-  uint8_t edge_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const;
+  uint8_t edge_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours, DistanceWindow& window) const;
 
   // Detects vertex centers (part of hull construction)
-  uint8_t vertex_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const;
+  uint8_t vertex_center(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours, DistanceWindow& window) const;
 
   // Backward marking phase (propagates hull selection)
   bool back_mark(uint8_t current_state, const std::vector<uint8_t>& neighbours) const;
@@ -123,8 +197,8 @@ private:
   bool exists_oposite_marked_neighbor(uint8_t current_state, const std::vector<uint8_t>& neighbours) const;
 
   // Checks if two regions belong to distinct wavefronts condition given by the book for edge center and vertex center detection
-  bool distinct_sets(const RuleContext& ctx, std::size_t nx, std::size_t ny, std::size_t index_x, std::size_t index_y, uint8_t goal_distance) const;
+  // (nx, ny) is the second center relative to the current cell
+  bool distinct_sets(DistanceWindow& window, Neighborhood neighborhood, int nx, int ny, std::size_t index_x, std::size_t index_y, uint8_t goal_distance) const;
 
-  // Helper to extract neighbor states for the distinct sets check (used by edge/vertex center logic)
-  std::pair<std::vector<uint8_t>, std::vector<uint8_t>> getDistinctNeighbourhoods(std::size_t nx, std::size_t ny, const RuleContext& ctx) const;
+  mutable std::vector<uint8_t> oracle_;
 };
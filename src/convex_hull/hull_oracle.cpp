@@ -0,0 +1,152 @@
+#include "hull_oracle.hpp"
+#include "convex_hull.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace hull_oracle {
+
+namespace {
+
+// > 0 when p is left of a -> b
+long cross(const Point& a, const Point& b, const Point& p) {
+  return (b.first - a.first) * (p.second - a.second) - (b.second - a.second) * (p.first - a.first);
+}
+
+long floor_div(long num, long den) {
+  long q = num / den;
+  if ((num % den != 0) && ((num < 0) != (den < 0))) --q;
+  return q;
+}
+
+long ceil_div(long num, long den) {
+  return -floor_div(-num, den);
+}
+
+// Digital segment a -> b: every step goes to the candidate closest to the real segment, ties go to the inside (left)
+void draw_edge(const Point& a, const Point& b, std::vector<uint8_t>& mask, std::size_t width, std::size_t height, Neighborhood neighborhood) {
+  const long sx = b.first > a.first ? 1 : (b.first < a.first ? -1 : 0);
+  const long sy = b.second > a.second ? 1 : (b.second < a.second ? -1 : 0);
+
+  auto put = [&](const Point& p) {
+    if (p.first >= 0 && p.second >= 0 && p.first < static_cast<long>(width) && p.second < static_cast<long>(height)) {
+      mask[idx(p.first, p.second, width)] = 1;
+    }
+  };
+
+  Point p = a;
+  put(p);
+  while (p != b) {
+    Point options[3];
+    int count = 0;
+    if (p.first != b.first) options[count++] = {p.first + sx, p.second};
+    if (p.second != b.second) options[count++] = {p.first, p.second + sy};
+    if (neighborhood == Neighborhood::Moore && p.first != b.first && p.second != b.second) options[count++] = {p.first + sx, p.second + sy};
+
+    Point best = options[0];
+    for (int i = 1; i < count; ++i) {
+      const long distance = std::labs(cross(a, b, options[i]));
+      const long best_distance = std::labs(cross(a, b, best));
+      if (distance < best_distance || (distance == best_distance && cross(a, b, options[i]) > cross(a, b, best))) {
+        best = options[i];
+      }
+    }
+
+    p = best;
+    put(p);
+  }
+}
+
+} // namespace
+
+std::vector<Point> monotone_chain(std::vector<Point> points) {
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  if (points.size() < 3) {
+    return points;
+  }
+
+  std::vector<Point> hull(2 * points.size());
+  std::size_t k = 0;
+
+  // Lower hull
+  for (const Point& p : points) {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], p) <= 0) --k;
+    hull[k++] = p;
+  }
+
+  // Upper hull
+  const std::size_t lower = k + 1;
+  for (std::size_t i = points.size() - 1; i > 0; --i) {
+    const Point& p = points[i - 1];
+    while (k >= lower && cross(hull[k - 2], hull[k - 1], p) <= 0) --k;
+    hull[k++] = p;
+  }
+
+  hull.resize(k - 1); // last point repeats the first
+  return hull;
+}
+
+std::vector<uint8_t> rasterize(const std::vector<Point>& hull, std::size_t width, std::size_t height, Neighborhood neighborhood) {
+  std::vector<uint8_t> mask(width * height, 0);
+  if (hull.empty()) {
+    return mask;
+  }
+
+  long min_y = hull[0].second;
+  long max_y = hull[0].second;
+  for (const Point& p : hull) {
+    min_y = std::min(min_y, p.second);
+    max_y = std::max(max_y, p.second);
+  }
+
+  // Row by row: the polygon is convex, so every row is one span between the leftmost and rightmost edge crossing
+  for (long y = std::max(min_y, 0L); y <= std::min(max_y, static_cast<long>(height) - 1); ++y) {
+    long left = static_cast<long>(width);
+    long right = -1;
+
+    for (std::size_t i = 0; i < hull.size(); ++i) {
+      const Point& a = hull[i];
+      const Point& b = hull[(i + 1) % hull.size()];
+      if (y < std::min(a.second, b.second) || y > std::max(a.second, b.second)) continue;
+
+      if (a.second == b.second) {
+        left = std::min({left, a.first, b.first});
+        right = std::max({right, a.first, b.first});
+        continue;
+      }
+
+      // x = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y), kept as a fraction so the rounding is exact
+      long num = a.first * (b.second - a.second) + (y - a.second) * (b.first - a.first);
+      long den = b.second - a.second;
+      if (den < 0) {
+        num = -num;
+        den = -den;
+      }
+      left = std::min(left, ceil_div(num, den));
+      right = std::max(right, floor_div(num, den));
+    }
+
+    for (long x = std::max(left, 0L); x <= std::min(right, static_cast<long>(width) - 1); ++x) {
+      mask[idx(x, y, width)] = 1;
+    }
+  }
+
+  for (std::size_t i = 0; i < hull.size(); ++i) {
+    draw_edge(hull[i], hull[(i + 1) % hull.size()], mask, width, height, neighborhood);
+  }
+
+  return mask;
+}
+
+std::vector<uint8_t> seed_hull(const std::vector<uint8_t>& cells, std::size_t width, std::size_t height, Neighborhood neighborhood) {
+  std::vector<Point> seeds;
+  for (std::size_t y = 0; y < height; ++y) {
+    for (std::size_t x = 0; x < width; ++x) {
+      if (is_seed(cells[idx(x, y, width)])) seeds.emplace_back(static_cast<long>(x), static_cast<long>(y));
+    }
+  }
+
+  return rasterize(monotone_chain(std::move(seeds)), width, height, neighborhood);
+}
+
+} // namespace hull_oracle
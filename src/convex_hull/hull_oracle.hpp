@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "core/grid.hpp"
+
+// Exact geometric convex hull of a set of cells, the reference the Convex Hull CA is compared against
+// Cheap enough to compute once per run (sort + one pass per row)
+namespace hull_oracle {
+
+using Point = std::pair<long, long>; // (x, y) cell coordinates
+
+// Andrew's monotone chain: hull vertices in counter-clockwise order (in x right / y up terms), collinear points dropped
+// One or two points come back as they are (after removing duplicates)
+std::vector<Point> monotone_chain(std::vector<Point> points);
+
+// Cells whose centers lie in the hull polygon plus its edges drawn as digital lines of the neighbourhood's connectivity
+// (4-connected for Von Neumann, 8-connected for Moore), 1 for hull cells and 0 elsewhere
+std::vector<uint8_t> rasterize(const std::vector<Point>& hull, std::size_t width, std::size_t height, Neighborhood neighborhood);
+
+// Both of the above for the seed cells of a Convex Hull grid
+std::vector<uint8_t> seed_hull(const std::vector<uint8_t>& cells, std::size_t width, std::size_t height, Neighborhood neighborhood);
+
+} // namespace hull_oracle
@@ -0,0 +1,117 @@
+#include "autosave_journal.hpp"
+#include "entropy_coder.hpp"
+#include "mapped_file.hpp"
+#include "snapshot_file.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr char MAGIC[6] = {'C', 'A', 'J', 'R', 'N', 'L'};
+constexpr std::size_t HEADER = 32;
+constexpr std::size_t RECORD_HEADER = 16;
+
+void put_u32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint32_t get_u32(const uint8_t* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  return value;
+}
+
+uint64_t get_u64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  return value;
+}
+
+}
+
+namespace autosave_journal {
+
+bool create(const std::filesystem::path& path, const std::vector<uint8_t>& cells) {
+  uint8_t header[HEADER] = {};
+  std::memcpy(header, MAGIC, sizeof(MAGIC));
+  header[6] = static_cast<uint8_t>(VERSION);
+  header[7] = static_cast<uint8_t>(VERSION >> 8);
+  put_u64(header + 8, snapshot_file::checksum(cells.data(), cells.size()));
+  put_u64(header + 16, cells.size());
+
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    if (!file) return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) std::filesystem::remove(temporary, ec);
+  return !ec;
+}
+
+bool append(const std::filesystem::path& path, const std::vector<uint8_t>& previous, const std::vector<uint8_t>& cells) {
+  if (previous.size() != cells.size()) return false;
+
+  std::vector<uint8_t> delta(cells.size());
+  for (std::size_t i = 0; i < delta.size(); ++i) delta[i] = cells[i] ^ previous[i];
+
+  std::vector<uint8_t> rle;
+  snapshot_file::encodeRle(delta, rle);
+  std::vector<uint8_t> coded;
+  entropy_coder::encode(rle.data(), rle.size(), coded);
+  const std::vector<uint8_t>& payload = coded.size() < rle.size() ? coded : rle;
+  if (rle.size() > UINT32_MAX) return false;
+
+  // Header and payload in one write, so a record is either all there or detectably cut off
+  std::vector<uint8_t> record(RECORD_HEADER + payload.size());
+  put_u32(record.data(), static_cast<uint32_t>(rle.size()));
+  put_u32(record.data() + 4, static_cast<uint32_t>(payload.size()));
+  put_u64(record.data() + 8, snapshot_file::checksum(payload.data(), payload.size()));
+  std::memcpy(record.data() + RECORD_HEADER, payload.data(), payload.size());
+
+  std::ofstream file(path, std::ios::binary | std::ios::app);
+  file.write(reinterpret_cast<const char*>(record.data()), static_cast<std::streamsize>(record.size()));
+  file.close();
+  return static_cast<bool>(file);
+}
+
+bool replay(const std::filesystem::path& path, std::vector<uint8_t>& cells) {
+  const MappedFile file(path);
+  const uint8_t* data = file.data();
+  if (!data || file.size() < HEADER) return false;
+  if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || (data[6] | (data[7] << 8)) != VERSION) return false;
+  if (get_u64(data + 16) != cells.size() || get_u64(data + 8) != snapshot_file::checksum(cells.data(), cells.size())) return false;
+
+  std::vector<uint8_t> rle;
+  std::vector<uint8_t> delta(cells.size());
+  std::size_t pos = HEADER;
+  while (file.size() - pos >= RECORD_HEADER) {
+    const std::size_t rle_size = get_u32(data + pos);
+    const std::size_t payload_size = get_u32(data + pos + 4);
+    const uint64_t checksum = get_u64(data + pos + 8);
+    const uint8_t* payload = data + pos + RECORD_HEADER;
+    if (payload_size > file.size() - pos - RECORD_HEADER || payload_size > rle_size) break;
+    if (snapshot_file::checksum(payload, payload_size) != checksum) break;
+
+    const uint8_t* run_lengths = payload;
+    if (payload_size < rle_size) {
+      rle.resize(rle_size);
+      if (!entropy_coder::decode(payload, payload_size, rle.data(), rle_size)) break;
+      run_lengths = rle.data();
+    }
+    if (!snapshot_file::decodeRle(run_lengths, rle_size, delta)) break;
+
+    for (std::size_t i = 0; i < cells.size(); ++i) cells[i] ^= delta[i];
+    pos += RECORD_HEADER + payload_size;
+  }
+  return true;
+}
+
+} // namespace autosave_journal
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+// Append-only log of the changes since a base save (autosave): each record is one later state of the grid, stored as
+// its XOR with the state before (run-length encoded, entropy coded when that is smaller)
+/*
+* Layout (little endian):
+*   0  magic "CAJRNL" + u16 version
+*   8  u64 base checksum (snapshot_file::checksum of the base cells), u64 cell count, u64 reserved
+*   records: u32 run-length size, u32 payload size (entropy coded when smaller than the run-length size),
+*            u64 payload checksum, payload
+* A record is written in one go at the end of the file; a cut off or damaged record ends the journal on reading, so a
+* crash while appending loses only that record
+*/
+namespace autosave_journal {
+
+inline constexpr uint16_t VERSION = 1;
+inline constexpr const char* EXTENSION = ".journal";
+
+// New empty journal for the base `cells` (written under a temporary name and renamed, replacing any old journal)
+bool create(const std::filesystem::path& path, const std::vector<uint8_t>& cells);
+
+// Appends the change from `previous` to `cells` (same size as the base)
+bool append(const std::filesystem::path& path, const std::vector<uint8_t>& previous, const std::vector<uint8_t>& cells);
+
+// Applies the journal's records to `cells` (the base it was created for); false when the file isn't a journal of
+// that base, in which case `cells` is left as it was. Stops quietly at the first incomplete or damaged record
+bool replay(const std::filesystem::path& path, std::vector<uint8_t>& cells);
+
+} // namespace autosave_journal
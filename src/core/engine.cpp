@@ -1,63 +1,437 @@
 #include "engine.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
 #include <thread>
+#include <utility>
+
+namespace {
+
+// Memory of one speculated Grid copy (cells, step buffer and change lists), roughly
+std::size_t speculation_bytes(const Grid& grid) {
+  return 3 * std::as_const(grid).getGridValues().size() + 2 * sizeof(std::size_t) * grid.getLastChangeCount();
+}
+
+}
 
 // Creates default grid and rule, then stores initial state in history
 Engine::Engine(std::size_t width, std::size_t height, std::string rule_key) 
   : grid_(width, height), rule_(RuleRegistry::getInstance().make(rule_key)), speed_(1.0), elapsed_time_(0.0), iteration_(0) {
-  history_.emplace_back(grid_.getGridValues());
+  history_.push(std::as_const(grid_).getGridValues());
+  publishSnapshot(0);
 }
 
 // Creates configured grid and rule, then stores initial state in history
 Engine::Engine(std::size_t width, std::size_t height, uint8_t default_state, Boundary boundary, Neighborhood neighborhood, std::string rule_key)
   : grid_(width, height, default_state, boundary, neighborhood), rule_(RuleRegistry::getInstance().make(rule_key)), speed_(1.0), elapsed_time_(0.0), iteration_(0) {
-  history_.emplace_back(grid_.getGridValues()); 
+  history_.push(std::as_const(grid_).getGridValues()); 
+  publishSnapshot(0);
+}
+
+Engine::~Engine() {
+  stop();
+  stopRecording();
+  std::lock_guard<std::mutex> lock(mtx_);
+  stopSpeculationLocked();
 }
 
 // Runs one simulation tick and records it
 void Engine::step() {
+  advance(true);
+}
+
+void Engine::advance(bool publish) {
+  std::optional<CycleInfo> entered;
+  std::function<void(const CycleInfo&)> callback;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (stepLocked(true)) {
+      entered = cycle_;
+      callback = cycle_callback_;
+    }
+    if (publish) publishSnapshot(iteration_.load(std::memory_order_relaxed));
+  }
+
+  // Outside the lock so the callback may call back into the engine
+  if (entered && callback) callback(*entered);
+}
+
+bool Engine::stepLocked(bool record) {
+  // Edits and config changes posted while the previous generation was computed
+  applyCommandsLocked();
+
+  // First step after reset/edit becomes the new history root
+  if (iteration_.load(std::memory_order_relaxed) == 0) {
+    history_.clear();
+    history_.push(std::as_const(grid_).getGridValues());
+    rule_->beginRun(grid_);
+    converged_iteration_.reset();
+    resetCycleDetection();
+    recordState(0);
+  }
+
+  // Stepping from a rewound generation replaces the future that was recorded after it
+  const std::size_t iteration = iteration_.load(std::memory_order_relaxed);
+  history_.truncate(iteration + 1);
+
+  // Rules that need a preprocessing layer (Convex Hull distances) run it inside Grid::step
+  // A generation speculated while paused is taken as it is (and doesn't count towards the measured step time)
+  if (!takeSpeculated(iteration)) {
+    const auto started = std::chrono::steady_clock::now();
+    grid_.step(*rule_);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    step_seconds_ = step_seconds_ > 0.0 ? 0.9 * step_seconds_ + 0.1 * seconds : seconds;
+  }
+
+  grid_.setIteration(iteration + 1);
+  if (record) {
+    recordGeneration(iteration + 1);
+  } else {
+    history_.skip(1);
+  }
+  recordFrameLocked(iteration + 1);
+  checkConvergence();
+
+  last_changes_.store(grid_.getLastChangeCount(), std::memory_order_relaxed);
+  const bool entered = recordState(iteration + 1);
+  iteration_.store(iteration + 1, std::memory_order_relaxed);
+  return entered;
+}
+
+// Batch on the background thread: the lock is held for a display frame's worth of generations at a time
+StepHandle Engine::stepAsync(std::size_t generations, StepOptions options) {
+  stop();
+  stopSpeculation();
+
+  StepHandle handle;
+  handle.state_ = std::make_shared<StepHandle::State>();
+  handle.state_->total = generations;
+
+  std::promise<std::size_t> result;
+  handle.result_ = result.get_future().share();
+
+  // A loop that ended on convergence still has to be joined
+  if (worker_.joinable()) worker_.join();
+
+  running_.store(true);
+  worker_ = std::jthread([this, state = handle.state_, options = std::move(options), result = std::move(result)](std::stop_token stoken) mutable {
+    using clock = std::chrono::steady_clock;
+    const auto chunk = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / TURBO_PUBLISH_RATE));
+    const bool stop_on_convergence = stop_on_convergence_.load(std::memory_order_relaxed);
+    const bool stop_on_cycle = stop_on_cycle_.load(std::memory_order_relaxed);
+
+    std::size_t done = 0;
+    bool ended = false;
+    while (done < state->total && !ended) {
+      std::optional<CycleInfo> entered;
+      std::function<void(const CycleInfo&)> callback;
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        const auto until = clock::now() + chunk;
+        do {
+          if (stop_on_convergence && converged_iteration_) ended = true;
+          if (stop_on_cycle && cycle_) ended = true;
+          if (ended) break;
+
+          // Only the last generation is guaranteed a frame when not recording all of them
+          // Generations of a rule that can't promise replays are always stored (checked per step, the rule may change)
+          const bool record = options.record_all || !rule_->isDeterministic() || done + 1 == state->total;
+          if (stepLocked(record)) entered = cycle_;
+          ++done;
+        } while (done < state->total && clock::now() < until && !stoken.stop_requested() && !state->cancelled.load(std::memory_order_relaxed));
+
+        ended = ended || stoken.stop_requested() || state->cancelled.load(std::memory_order_relaxed);
+
+        // A batch cut short still ends on a recorded generation
+        const std::size_t iteration = iteration_.load(std::memory_order_relaxed);
+        if ((ended || done == state->total) && !history_.has(iteration)) {
+          history_.truncate(iteration);
+          history_.push(std::as_const(grid_).getGridValues());
+          if (history_mode_ == HistoryMode::Exponential) thinCheckpoints(iteration);
+        }
+
+        publishSnapshot(iteration);
+        if (entered) callback = cycle_callback_;
+      }
+
+      state->done.store(done, std::memory_order_relaxed);
+      if (entered && callback) callback(*entered);
+      if (options.on_progress) options.on_progress(done, state->total);
+    }
+
+    running_.store(false);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (applyCommandsLocked()) publishSnapshot(iteration_.load(std::memory_order_relaxed));
+    }
+    result.set_value(done);
+  });
+
+  return handle;
+}
+
+// Records the first generation the rule calls converged
+void Engine::checkConvergence() {
+  if (!converged_iteration_ && rule_->hasConverged(grid_)) {
+    converged_iteration_ = grid_.getIteration();
+  }
+}
+
+// Full history stores everything, sparse modes only a checkpoint once the interval has passed
+void Engine::recordGeneration(std::size_t iteration) {
+  if (history_mode_ == HistoryMode::Full) {
+    history_.push(std::as_const(grid_).getGridValues());
+    return;
+  }
+
+  const auto last = history_.lastRecorded(iteration);
+  if (last && iteration - *last < checkpointInterval()) {
+    history_.skip(1);
+    return;
+  }
+
+  history_.push(std::as_const(grid_).getGridValues());
+  if (history_mode_ == HistoryMode::Exponential) thinCheckpoints(iteration);
+}
+
+// Heuristic K: as sparse as the rewind target allows (replaying an interval costs about K step times), and at
+// least sparse enough that checkpoints for the run so far fit the history budget
+std::size_t Engine::checkpointInterval() const {
+  if (checkpoint_interval_ > 0) return std::max<std::size_t>(checkpoint_interval_, 2);
+
+  std::size_t interval = MAX_AUTO_INTERVAL;
+  if (step_seconds_ > 0.0) {
+    interval = static_cast<std::size_t>(std::min(REWIND_TARGET_SECONDS / step_seconds_, static_cast<double>(MAX_AUTO_INTERVAL)));
+  }
+
+  const std::size_t budget = history_.getMemoryBudget();
+  const auto last = history_.empty() ? std::nullopt : history_.lastRecorded(history_.size() - 1);
+  if (budget > 0 && last) {
+    const std::size_t run_length = iteration_.load(std::memory_order_relaxed) + 1;
+    interval = std::max(interval, run_length * history_.frameBytes(*last) / budget + 1);
+  }
+
+  return std::max<std::size_t>(interval, 2);
+}
+
+// Drops checkpoints whose neighbours are already close enough for their age, keeping gaps around age / density
+void Engine::thinCheckpoints(std::size_t iteration) {
+  const std::vector<std::size_t> checkpoints = history_.recordedGenerations();
+  if (checkpoints.size() < 3) return;
+
+  const std::size_t base = checkpointInterval();
+  std::size_t kept_newer = checkpoints.back();
+  for (std::size_t k = checkpoints.size() - 2; k >= 1; --k) {
+    const std::size_t allowed = std::max(base, (iteration - kept_newer) / EXPONENTIAL_DENSITY);
+    if (kept_newer - checkpoints[k - 1] <= allowed && history_.drop(checkpoints[k])) {
+      continue;
+    }
+    kept_newer = checkpoints[k];
+  }
+}
+
+// Nearest stored generation, then plain stepping (or the rule's shortcut) up to the wanted one
+bool Engine::replayTo(Grid& grid, std::size_t current, std::size_t iteration) {
+  if (!rule_->isDeterministic()) return false;
+
+  // Generations before a settings change were computed with other settings than the ones stepping now
+  const auto checkpoint = history_.lastRecorded(iteration);
+  if (!checkpoint || *checkpoint < history_.settingsBarrier()) return false;
+
+  // Moving forward from a generation past the checkpoint continues from the grid as it is
+  if (current < *checkpoint || current > iteration) {
+    grid.setGridValues(history_.get(*checkpoint));
+    current = *checkpoint;
+  }
+  grid.setIteration(current);
+
+  if (current < iteration) {
+    // The shortcut only stops early at a fixed point, which is then the wanted generation as well
+    const std::size_t advanced = rule_->fastForward(grid.getGridValues(), grid.getWidth(), grid.getHeight(), grid.getNeighborhood(), grid.getBoundary(), iteration - current);
+    if (advanced > 0) current = iteration;
+  }
+
+  while (current < iteration) {
+    grid.step(*rule_);
+    grid.setIteration(++current);
+  }
+
+  grid.setIteration(iteration);
+  return true;
+}
+
+// Looks the current generation up among the earlier ones of this run
+bool Engine::recordState(std::size_t iteration) {
+  if (cycle_) return false;
+
+  const uint64_t hash = grid_.getHash();
+  const std::size_t phase = rule_->timePhase(grid_);
+  const uint64_t key = hash ^ (static_cast<uint64_t>(phase) * 0x9E3779B97F4A7C15ull);
+
+  const auto [it, inserted] = seen_states_.try_emplace(key, SeenState{iteration, phase});
+  if (inserted || it->second.iteration >= iteration || it->second.phase != phase) return false;
+
+  // A 64-bit collision is unlikely but cheap to rule out while both frames are still recorded
+  const std::size_t first = it->second.iteration;
+  const bool frames_line_up = history_.size() == iteration + 1;
+  if (frames_line_up && history_.has(first) && history_.get(first) != std::as_const(grid_).getGridValues()) {
+    it->second = SeenState{iteration, phase};
+    return false;
+  }
+
+  cycle_ = CycleInfo{first, iteration - first};
+  return true;
+}
+
+void Engine::resetCycleDetection() {
+  seen_states_.clear();
+  cycle_.reset();
+}
+
+// Jumps several generations at once and records only the final state
+std::size_t Engine::fastForward(std::size_t generations) {
+  if (generations == 0) return 0;
+
+  std::size_t advanced = 0;
+  std::optional<CycleInfo> entered;
+  std::function<void(const CycleInfo&)> callback;
   {
     std::lock_guard<std::mutex> lock(mtx_);
 
-    // First step after reset/edit becomes the new history root
-    if (iteration_.load(std::memory_order_relaxed) == 0) {
+    const std::size_t start = iteration_.load(std::memory_order_relaxed);
+    invalidateSpeculation();
+    history_.truncate(start + 1);
+    if (start == 0) {
       history_.clear();
-      history_.emplace_back(grid_.getGridValues());
+      history_.push(std::as_const(grid_).getGridValues());
+      rule_->beginRun(grid_);
+      converged_iteration_.reset();
+      resetCycleDetection();
+      recordState(0);
     }
 
-    // Optional preprocessing layer before the rule updates cells used for Convex Hull exclusively right now
-    if (calculating_distances_.load(std::memory_order_relaxed) && distance_calculator_) {
-      distance_calculator_(grid_.getGridValues(), grid_.getWidth(), grid_.getHeight(), grid_.getNeighborhood(), grid_.getBoundary());
+    advanced = rule_->fastForward(grid_.getGridValues(), grid_.getWidth(), grid_.getHeight(), grid_.getNeighborhood(), grid_.getBoundary(), generations);
+
+    // No shortcut: plain stepping, just without recording every frame
+    if (advanced == 0) {
+      const bool stop_on_convergence = stop_on_convergence_.load(std::memory_order_relaxed);
+      const bool stop_on_cycle = stop_on_cycle_.load(std::memory_order_relaxed);
+      while (advanced < generations) {
+        grid_.step(*rule_);
+        ++advanced;
+        grid_.setIteration(start + advanced);
+
+        checkConvergence();
+        last_changes_.store(grid_.getLastChangeCount(), std::memory_order_relaxed);
+        if (recordState(start + advanced)) entered = cycle_;
+        recordFrameLocked(start + advanced);
+
+        if (stop_on_convergence && converged_iteration_) break;
+        if (stop_on_cycle && cycle_) break;
+      }
     }
 
-    grid_.step(*rule_);
-    grid_.setIteration(iteration_.load(std::memory_order_relaxed) + 1);
-    history_.emplace_back(grid_.getGridValues());
+    grid_.setIteration(start + advanced);
+    history_.skip(advanced - 1);
+    history_.push(std::as_const(grid_).getGridValues());
+    if (history_mode_ == HistoryMode::Exponential) thinCheckpoints(start + advanced);
+    checkConvergence();
+    if (recordState(start + advanced)) entered = cycle_;
+    if (entered) callback = cycle_callback_;
+    publishSnapshot(start + advanced);
   }
 
-  iteration_.fetch_add(1, std::memory_order_relaxed);
+  iteration_.fetch_add(advanced, std::memory_order_relaxed);
+
+  if (entered && callback) callback(*entered);
+  return advanced;
 }
 
 // Starts continuous stepping in a background thread
 void Engine::start() {
-  if (worker_.joinable()) return;
-  
+  if (running_.load()) return;
+
+  // The loop takes what was speculated but computes the rest itself
+  stopSpeculation();
+
+  // A loop that ended on convergence still has to be joined
+  if (worker_.joinable()) worker_.join();
+
+  running_.store(true);
   worker_ = std::jthread([this](std::stop_token stoken) {
-    while (true) {
-      if (stoken.stop_requested()) break;
+    using clock = std::chrono::steady_clock;
+    const auto publish_period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / TURBO_PUBLISH_RATE));
+
+    auto tick = clock::now(); // when the step about to be taken was due
+    auto next_publish = tick;
+    std::size_t batch = 1;
 
-      step();
+    while (!stoken.stop_requested()) {
+      if (stop_on_convergence_.load(std::memory_order_relaxed) && getConvergedIteration()) break;
+      if (stop_on_cycle_.load(std::memory_order_relaxed) && getCycle()) break;
 
-      double speed = speed_.load(std::memory_order_relaxed);
-      if (speed <= 0.0) speed = 1.0;
+      if (max_throughput_.load(std::memory_order_relaxed)) {
+        const auto started = clock::now();
+        if (turbo_skip_history_.load(std::memory_order_relaxed)) {
+          // Batches of about one display frame, each records and publishes only its last generation
+          fastForward(batch);
+          const auto took = clock::now() - started;
+          if (took < publish_period / 2) batch = std::min(batch * 2, MAX_TURBO_BATCH);
+          else if (took > publish_period * 2) batch = std::max<std::size_t>(batch / 2, 1);
+        } else {
+          const bool publish = started >= next_publish;
+          advance(publish);
+          if (publish) next_publish = started + publish_period;
+        }
+        tick = clock::now(); // leaving max throughput resumes the fixed rate from here
+        continue;
+      }
 
-      // Simple fixed delay, doesn't compensate for step() time
-      std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(1.0 / speed * 1000))); 
+      advance(true);
+
+      // Next deadline is a whole period after the previous one, so the time step() took doesn't lower the rate
+      std::unique_lock<std::mutex> lock(schedule_mtx_);
+      while (!stoken.stop_requested()) {
+        double speed = speed_.load(std::memory_order_relaxed);
+        if (speed <= 0.0) speed = 1.0;
+        const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / speed));
+
+        const auto now = clock::now();
+        if (now - tick > period * static_cast<int>(MAX_CATCH_UP_TICKS + 1)) tick = now - period;
+
+        const auto due = tick + period;
+        if (now >= due || max_throughput_.load(std::memory_order_relaxed)) {
+          tick = due;
+          break;
+        }
+
+        // Wakes at the deadline, on stop, or when the speed/mode changed (the deadline is then worked out again)
+        const uint64_t version = schedule_version_;
+        schedule_cv_.wait_until(lock, stoken, due, [&] { return schedule_version_ != version; });
+      }
     }
+
+    // Generations max throughput didn't publish
+    refreshSnapshot();
+    running_.store(false);
+
+    // Edits posted while the loop was ending (post applies them itself once it sees the loop isn't running)
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (applyCommandsLocked()) publishSnapshot(iteration_.load(std::memory_order_relaxed));
   });
    
 }
 
+void Engine::wakeWorker() {
+  {
+    std::lock_guard<std::mutex> lock(schedule_mtx_);
+    ++schedule_version_;
+  }
+  schedule_cv_.notify_all();
+}
+
 // Stops background simulation cleanly
 void Engine::stop() {
   if (worker_.joinable()) {
@@ -68,7 +442,44 @@ void Engine::stop() {
 
 // UI helper: play/pause
 void Engine::toggleRunning() {
-  (worker_.joinable()) ? stop() : start();
+  isRunning() ? stop() : start();
+}
+
+bool Engine::isRunning() const {
+  return running_.load();
+}
+
+std::optional<std::size_t> Engine::getConvergedIteration() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return converged_iteration_;
+}
+
+std::optional<CycleInfo> Engine::getCycle() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return cycle_;
+}
+
+void Engine::setCycleCallback(std::function<void(const CycleInfo&)> callback) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  cycle_callback_ = std::move(callback);
+}
+
+uint64_t Engine::getStateHash() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return grid_.getHash();
+}
+
+// Plain stepping with a convergence check after every generation
+std::optional<std::size_t> Engine::runUntilConverged(std::size_t max_generations) {
+  stop();
+  if (auto converged = getConvergedIteration()) return converged;
+
+  for (std::size_t i = 0; i < max_generations; ++i) {
+    step();
+    if (auto converged = getConvergedIteration()) return converged;
+  }
+
+  return getConvergedIteration();
 }
 
 // Restores first recorded state and clears future history
@@ -78,11 +489,15 @@ void Engine::reset() {
     std::lock_guard<std::mutex> lock(mtx_);
     if (history_.empty()) return;
 
-    std::vector<uint8_t> initial_state = history_.front();
+    std::vector<uint8_t> initial_state = history_.get(0);
+    invalidateSpeculation();
     grid_.setGridValues(initial_state);
     history_.clear();
-    history_.emplace_back(initial_state);
+    history_.push(initial_state);
     iteration_.store(0, std::memory_order_relaxed);
+    converged_iteration_.reset();
+    resetCycleDetection();
+    publishSnapshot(0);
   }
 }
 
@@ -93,9 +508,13 @@ void Engine::clean() {
     std::lock_guard<std::mutex> lock(mtx_);
 
     std::vector<uint8_t> empty_state(grid_.getWidth() * grid_.getHeight(), 0);
-    history_.pop_back();
+    invalidateSpeculation();
+    history_.truncate(history_.size() - 1);
     grid_.setGridValues(empty_state);
-    history_.emplace_back(empty_state);
+    history_.push(empty_state);
+    history_.pin(history_.size() - 1);
+    resetCycleDetection();
+    publishSnapshot(iteration_.load(std::memory_order_relaxed));
   }
 }
 
@@ -107,7 +526,15 @@ Grid& Engine::getGrid() {
 // Sets target steps per second
 void Engine::setSpeed(double speed) {
   if (speed < 0.0) speed = 0.0; // TODO: decide if I should allow 0 but it is double so compare carefully
-  speed_.store(speed, std::memory_order_relaxed);
+
+  // The UI sets the speed every frame, only actual changes reschedule the loop
+  if (speed_.exchange(speed, std::memory_order_relaxed) != speed) wakeWorker();
+}
+
+void Engine::setMaxThroughput(bool on, bool skip_history) {
+  turbo_skip_history_.store(skip_history, std::memory_order_relaxed);
+  max_throughput_.store(on, std::memory_order_relaxed);
+  wakeWorker();
 }
 
 double Engine::getSpeed() const {
@@ -119,33 +546,264 @@ std::size_t Engine::getIteration() const {
 }
 
 // Exposes whole history; caller must not assume it stays stable while running
-const std::vector<std::vector<uint8_t>>& Engine::getHistory() {
+const History& Engine::getHistory() {
   std::lock_guard<std::mutex> lock(mtx_);
   return history_;
 }
 
+HistoryStats Engine::getHistoryStats() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return history_.getStats();
+}
+
+void Engine::setHistoryBudget(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  history_.setMemoryBudget(bytes);
+}
+
+void Engine::setHistorySpillDirectory(const std::filesystem::path& directory) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  history_.setSpillDirectory(directory);
+}
+
+std::size_t Engine::getHistoryBudget() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return history_.getMemoryBudget();
+}
+
+bool Engine::setHistoryMode(HistoryMode mode, std::size_t interval) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (mode != HistoryMode::Full && !rule_->isDeterministic()) return false;
+
+  history_mode_ = mode;
+  checkpoint_interval_ = interval;
+  return true;
+}
+
+HistoryMode Engine::getHistoryMode() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return history_mode_;
+}
+
+std::size_t Engine::getCheckpointInterval() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return checkpointInterval();
+}
+
 // Returns saved state for a specific generation
-const std::vector<uint8_t>& Engine::getStateAtIteration(std::size_t iteration) {
+std::vector<uint8_t> Engine::getStateAtIteration(std::size_t iteration) {
   std::lock_guard<std::mutex> lock(mtx_);
-  if (iteration < history_.size()) {
-    return history_[iteration];
+  if (history_.has(iteration)) {
+    return history_.get(iteration);
   }
   throw std::out_of_range("Iteration out of range in getStateAtIteration");
 }
 
-// Replaces current grid and appends it as a new history state
+// Replaces current grid and records it as the current generation
 void Engine::setGridValues(const std::vector<uint8_t>& new_grid_values) {
   std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
   grid_.setGridValues(new_grid_values);
-  history_.emplace_back(new_grid_values);
+  history_.truncate(iteration_.load(std::memory_order_relaxed));
+  history_.push(new_grid_values);
+  history_.pin(history_.size() - 1); // not the step of the generation before, replays start here
+  resetCycleDetection();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
+}
+
+// Same, without copying the cells into the grid
+void Engine::setGridValues(std::vector<uint8_t>&& new_grid_values) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  grid_.setGridValues(std::move(new_grid_values));
+  history_.truncate(iteration_.load(std::memory_order_relaxed));
+  history_.push(std::as_const(grid_).getGridValues());
+  history_.pin(history_.size() - 1);
+  resetCycleDetection();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
+}
+
+void Engine::post(EngineCommand command) {
+  commands_.push(std::move(command));
+
+  // A running engine drains the queue before its next generation (and once more when its loop ends)
+  if (!running_.load()) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (applyCommandsLocked()) publishSnapshot(iteration_.load(std::memory_order_relaxed));
+  }
+}
+
+// One batch: config changes in order, cell writes straight into the grid (a row at a time), then one history frame for the edits
+bool Engine::applyCommandsLocked() {
+  if (commands_.empty()) return false;
+
+  bool cells_changed = false;
+  const std::size_t applied = commands_.drain([&](EngineCommand&& command) {
+    if (const auto* edit = std::get_if<CellEdit>(&command)) {
+      grid_.setCell(edit->x, edit->y, edit->state);
+      cells_changed = true;
+    } else if (const auto* fill = std::get_if<RegionFill>(&command)) {
+      grid_.fill(fill->x, fill->y, fill->width, fill->height, fill->state);
+      cells_changed = true;
+    } else if (const auto* stamp = std::get_if<PatternStamp>(&command)) {
+      if (stamp->mask.empty()) {
+        grid_.blit(stamp->cells, stamp->width, stamp->x, stamp->y);
+      } else {
+        grid_.stamp(stamp->cells, stamp->width, stamp->x, stamp->y, stamp->mask);
+      }
+      cells_changed = true;
+    } else if (const auto* boundary = std::get_if<BoundaryChange>(&command)) {
+      setBoundaryLocked(boundary->boundary);
+    } else if (const auto* neighborhood = std::get_if<NeighborhoodChange>(&command)) {
+      setNeighborhoodLocked(neighborhood->neighborhood);
+    } else if (auto* rule = std::get_if<RuleChange>(&command)) {
+      if (rule->rule) setRuleLocked(std::move(rule->rule));
+    } else if (const auto* resize = std::get_if<GridResize>(&command)) {
+      resizeGridLocked(resize->width, resize->height);
+    }
+  });
+
+  // The edited state replaces the current generation, as setGridValues does
+  if (cells_changed) {
+    invalidateSpeculation();
+    history_.truncate(iteration_.load(std::memory_order_relaxed));
+    history_.push(std::as_const(grid_).getGridValues());
+    history_.pin(history_.size() - 1);
+    resetCycleDetection();
+  }
+  return applied > 0;
+}
+
+// Rewrites the history root and brings the recorded run up to date generation by generation
+void Engine::editInput(const std::vector<CellEdit>& edits) {
+  stop();
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (history_.empty()) return;
+
+  // The rerun sets the rule up again (Rule::beginRun), which mustn't happen under a speculating thread
+  invalidateSpeculation();
+
+  const std::size_t width = grid_.getWidth();
+  const std::size_t height = grid_.getHeight();
+  const std::size_t iterations = iteration_.load(std::memory_order_relaxed);
+
+  // Cells where the rerun differs from the recorded generation it is at
+  std::vector<std::size_t> differing;
+  std::vector<uint8_t> root = history_.get(0);
+  for (const auto& edit : edits) {
+    if (edit.x >= width || edit.y >= height) continue;
+
+    const std::size_t i = idx(edit.x, edit.y, width);
+    if (root[i] != edit.state) {
+      root[i] = edit.state;
+      differing.push_back(i);
+    }
+  }
+
+  if (differing.empty()) {
+    return;
+  }
+
+  // The rerun is recorded into a new history while the old one is still read as the reference
+  History rebuilt;
+  rebuilt.setMemoryBudget(history_.getMemoryBudget());
+  rebuilt.setSpillDirectory(history_.getSpillDirectory());
+  rebuilt.push(root);
+  grid_.setGridValues(root);
+  if (iterations == 0) {
+    history_ = std::move(rebuilt);
+    publishSnapshot(0);
+    return;
+  }
+
+  // The edited run may converge (or cycle) elsewhere, the next generation checks again
+  converged_iteration_.reset();
+  resetCycleDetection();
+
+  // A rule whose run setup depends on the input can't be compared against generations of the old setup, and
+  // neither can generations computed with other settings
+  bool replaying = !rule_->beginRun(grid_) && history_.settingsBarrier() == 0;
+
+  const bool replayable = replaying;
+  for (std::size_t t = 0; t < iterations; ++t) {
+    grid_.setIteration(t);
+
+    if (!history_.has(t + 1)) {
+      // Generation skipped by fastForward: nothing to replay against, step it and compare again once frames exist
+      grid_.step(*rule_);
+      rebuilt.skip(1);
+      replaying = false;
+      continue;
+    }
+
+    if (replaying && differing.empty() && history_.has(iterations)) {
+      // The edit no longer reaches anything, the rest of the recorded run stays as it is
+      rebuilt.appendTail(std::move(history_), t + 1);
+      grid_.setGridValues(rebuilt.get(iterations));
+      break;
+    }
+
+    if (replaying) {
+      grid_.replayStep(*rule_, history_.get(t + 1), differing);
+    } else {
+      grid_.step(*rule_);
+
+      if (replayable) {
+        const auto& cells = std::as_const(grid_).getGridValues();
+        const auto& recorded = history_.get(t + 1);
+        differing.clear();
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+          if (cells[i] != recorded[i]) differing.push_back(i);
+        }
+        replaying = true;
+      }
+    }
+
+    rebuilt.push(std::as_const(grid_).getGridValues());
+    if (history_.pinned(t + 1)) rebuilt.pin(t + 1);
+  }
+
+  // Generations past the current one only survive when the old run was taken over above
+  history_ = std::move(rebuilt);
+  grid_.setIteration(iterations);
+
+  if (verify_input_edits_) {
+    Grid reference(width, height, 0, grid_.getBoundary(), grid_.getNeighborhood());
+    reference.setGridValues(history_.get(0));
+    rule_->beginRun(reference);
+    for (std::size_t t = 0; t < iterations; ++t) {
+      reference.setIteration(t);
+      reference.step(*rule_);
+    }
+    reference.setIteration(iterations);
+
+    if (std::as_const(reference).getGridValues() != std::as_const(grid_).getGridValues()) {
+      input_edit_mismatches_.fetch_add(1, std::memory_order_relaxed);
+      grid_.setGridValues(std::as_const(reference).getGridValues());
+      if (history_.has(iterations)) {
+        history_.truncate(iterations);
+        history_.push(std::as_const(grid_).getGridValues());
+      }
+    }
+  }
+
+  publishSnapshot(iterations);
 }
 
 // Jumps to a recorded generation if it still exists
 bool Engine::goToIteration(std::size_t iteration) {
   std::lock_guard<std::mutex> lock(mtx_);
-  if (iteration < history_.size()) {
-    grid_.setGridValues(history_[iteration]);
+  if (iteration < history_.size() && (history_.has(iteration) || replayTo(grid_, iteration_.load(std::memory_order_relaxed), iteration))) {
+    invalidateSpeculation();
+    if (history_.has(iteration)) grid_.setGridValues(history_.get(iteration));
+    grid_.setIteration(iteration);
     iteration_.store(iteration, std::memory_order_relaxed);
+    if (converged_iteration_ && iteration < *converged_iteration_) converged_iteration_.reset();
+
+    // Generations after the target get stepped again, so they have to be seen again
+    std::erase_if(seen_states_, [iteration](const auto& entry) { return entry.second.iteration > iteration; });
+    if (cycle_ && iteration < cycle_->start + cycle_->period) cycle_.reset();
+    publishSnapshot(iteration);
     return true;
   }
   return false;
@@ -157,74 +815,513 @@ void Engine::stepBack(std::size_t steps) {
 
   if (steps > iteration_.load(std::memory_order_relaxed)) {
     reset();
-  } else {
-    goToIteration(iteration_.load(std::memory_order_relaxed) - steps);
+    return;
+  }
+
+  // Frames skipped by fastForward aren't stored, land on the closest earlier one instead
+  std::size_t target = iteration_.load(std::memory_order_relaxed) - steps;
+  while (!goToIteration(target) && target > 0) {
+    --target;
   }
 }
 
 // Resizes grid and starts a fresh history timeline
 void Engine::resizeGrid(std::size_t new_width, std::size_t new_height) {
   stop();
+  std::lock_guard<std::mutex> lock(mtx_);
+  resizeGridLocked(new_width, new_height);
+}
+
+void Engine::resizeGridLocked(std::size_t new_width, std::size_t new_height) {
+  invalidateSpeculation();
+  grid_.resize(new_width, new_height);
+  reshapedLocked();
+}
+
+void Engine::cropGrid(std::size_t x, std::size_t y, std::size_t width, std::size_t height) {
+  stop();
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  grid_.crop(x, y, width, height);
+  reshapedLocked();
+}
+
+void Engine::padGrid(std::size_t left, std::size_t top, std::size_t right, std::size_t bottom) {
+  stop();
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  grid_.pad(left, top, right, bottom);
+  reshapedLocked();
+}
+
+void Engine::transformGrid(GridTransform transform) {
+  stop();
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  switch (transform) {
+    case GridTransform::RotateClockwise:
+      grid_.rotate90(true);
+      break;
+    case GridTransform::RotateCounterclockwise:
+      grid_.rotate90(false);
+      break;
+    case GridTransform::Rotate180:
+      grid_.rotate180();
+      break;
+    case GridTransform::FlipHorizontal:
+      grid_.flipHorizontal();
+      break;
+    case GridTransform::FlipVertical:
+      grid_.flipVertical();
+      break;
+  }
+  reshapedLocked();
+}
+
+std::vector<uint8_t> Engine::copyRegion(std::size_t x, std::size_t y, std::size_t width, std::size_t height) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return grid_.copyRegion(x, y, width, height);
+}
+
+void Engine::reshapedLocked() {
+  // Frames of another layout don't fit the recording; finishing joins its writer, which never takes mtx_
+  if (recorder_) {
+    recorder_->finish();
+    recorder_.reset();
+  }
+  history_.clear();
+  history_.push(std::as_const(grid_).getGridValues());
+  iteration_.store(0, std::memory_order_relaxed);
+  converged_iteration_.reset();
+  resetCycleDetection();
+  publishSnapshot(0);
+}
+
+// New engine on the same config whose history starts out as the shared prefix of this one
+std::unique_ptr<Engine> Engine::fork(std::size_t iteration, std::unique_ptr<Rule> rule) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (iteration >= history_.size()) return nullptr;
+
+  // The generation to branch from, recomputed into a copy when it wasn't stored
+  Grid state = grid_;
+  if (history_.has(iteration)) {
+    state.setGridValues(history_.get(iteration));
+  } else if (!replayTo(state, iteration_.load(std::memory_order_relaxed), iteration)) {
+    return nullptr;
+  }
+  state.setIteration(iteration);
+  state.invalidateActiveBand();
+
+  const bool same_rule = !rule;
+  auto branch = std::make_unique<Engine>(grid_.getWidth(), grid_.getHeight(), 0, grid_.getBoundary(), grid_.getNeighborhood(), rule_->getName());
+  if (rule) {
+    branch->rule_ = std::move(rule);
+  } else {
+    // Same rule, same settings: the shared history and run state hold for the branch only with its parameters
+    branch->rule_->setParameters(rule_->getParameters());
+  }
+
+  branch->grid_ = std::move(state);
+  branch->iteration_.store(iteration, std::memory_order_relaxed);
+  branch->speed_.store(speed_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  branch->stop_on_convergence_.store(stop_on_convergence_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  branch->stop_on_cycle_.store(stop_on_cycle_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  branch->verify_input_edits_ = verify_input_edits_;
+  branch->step_seconds_ = step_seconds_;
+  branch->checkpoint_interval_ = checkpoint_interval_;
+  branch->history_mode_ = branch->rule_->isDeterministic() ? history_mode_ : HistoryMode::Full;
+
+  if (history_.has(iteration)) {
+    branch->history_ = history_.share(iteration + 1);
+  } else {
+    branch->history_ = history_.share(iteration);
+    branch->history_.push(std::as_const(branch->grid_).getGridValues());
+  }
+  if (!same_rule) {
+    branch->history_.pin(iteration);
+    branch->history_.setSettingsBarrier(iteration);
+  }
+
+  // The fork continues the run that started at the root, so its rule gets the same run setup
+  if (iteration > 0) {
+    Grid root = grid_;
+    root.setGridValues(history_.get(0));
+    root.setIteration(0);
+    branch->rule_->beginRun(root);
+  }
+
+  if (same_rule) {
+    // Whatever the run showed up to the fork point still holds for the branch
+    if (converged_iteration_ && *converged_iteration_ <= iteration) branch->converged_iteration_ = converged_iteration_;
+    for (const auto& [key, seen] : seen_states_) {
+      if (seen.iteration <= iteration) branch->seen_states_.emplace(key, seen);
+    }
+    if (cycle_ && cycle_->start + cycle_->period <= iteration) branch->cycle_ = cycle_;
+  } else {
+    branch->recordState(iteration);
+  }
+
+  branch->publishSnapshot(iteration);
+  return branch;
+}
+
+std::vector<std::size_t> Engine::diff(Engine& other) {
+  if (&other == this) return {};
+  std::scoped_lock lock(mtx_, other.mtx_);
+
+  const auto& cells = std::as_const(grid_).getGridValues();
+  const auto& other_cells = std::as_const(other.grid_).getGridValues();
+  if (cells.size() != other_cells.size()) {
+    throw std::invalid_argument("Engine::diff: grids have different sizes");
+  }
+  if (grid_.getHash() == other.grid_.getHash() && cells == other_cells) return {};
+
+  // Rows compare as whole blocks first, only the ones that differ are scanned cell by cell
+  std::vector<std::size_t> differing;
+  const std::size_t width = grid_.getWidth();
+  for (std::size_t row = 0; row < cells.size(); row += width) {
+    if (std::equal(cells.begin() + row, cells.begin() + row + width, other_cells.begin() + row)) continue;
+    for (std::size_t i = row; i < row + width; ++i) {
+      if (cells[i] != other_cells[i]) differing.push_back(i);
+    }
+  }
+  return differing;
+}
+
+std::optional<std::size_t> Engine::firstDivergence(Engine& other) {
+  if (&other == this) return std::nullopt;
+  std::scoped_lock lock(mtx_, other.mtx_);
+
+  const std::size_t shared = history_.sharedPrefix(other.history_);
+  const std::size_t common = std::min(history_.size(), other.history_.size());
+  for (std::size_t i = shared; i < common; ++i) {
+    if (!history_.has(i) || !other.history_.has(i)) continue;
+
+    // get() references stay valid only until the next access, so one side is copied
+    const std::vector<uint8_t> cells = history_.get(i);
+    if (cells != other.history_.get(i)) return i;
+  }
+  return std::nullopt;
+}
+
+bool Engine::startRecording(const std::filesystem::path& path) {
+  stopRecording();
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  SavedGrid settings;
+  settings.width = grid_.getWidth();
+  settings.height = grid_.getHeight();
+  settings.boundary = grid_.getBoundary();
+  settings.neighborhood = grid_.getNeighborhood();
+  settings.rule = rule_->getName();
+  settings.rule_parameters = rule_->getParameters();
+
+  const std::size_t iteration = iteration_.load(std::memory_order_relaxed);
+  recorder_ = recording_file::Writer::create(path, settings, iteration);
+  if (!recorder_) return false;
+
+  recorder_->put(iteration, grid_.getHash(), std::as_const(grid_).getGridValues());
+  recorded_iteration_ = iteration;
+  recorded_hash_ = grid_.getHash();
+  return true;
+}
+
+bool Engine::stopRecording() {
+  std::unique_ptr<recording_file::Writer> recorder;
   {
     std::lock_guard<std::mutex> lock(mtx_);
-    grid_.resize(new_width, new_height);
-    history_.clear();
-    history_.emplace_back(grid_.getGridValues());
-    iteration_.store(0, std::memory_order_relaxed);
+    recorder = std::move(recorder_);
   }
+  // Draining what is still queued can take a moment, steps go on meanwhile
+  return recorder && recorder->finish();
+}
+
+bool Engine::isRecording() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return recorder_ != nullptr;
+}
+
+std::size_t Engine::getRecordedGenerations() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return recorder_ ? recorder_->size() : 0;
+}
+
+std::size_t Engine::getRecordingBytes() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return recorder_ ? recorder_->fileBytes() : 0;
+}
+
+void Engine::recordFrameLocked(std::size_t iteration) {
+  if (!recorder_) return;
+
+  const uint64_t hash = grid_.getHash();
+  if (iteration == recorded_iteration_ && hash == recorded_hash_) return;
+
+  recorder_->put(iteration, hash, std::as_const(grid_).getGridValues());
+  recorded_iteration_ = iteration;
+  recorded_hash_ = hash;
 }
 
 // Changes neighborhood for future steps
 void Engine::setNeighborhood(Neighborhood neighborhood) {
   std::lock_guard<std::mutex> lock(mtx_);
+  setNeighborhoodLocked(neighborhood);
+}
+
+void Engine::setNeighborhoodLocked(Neighborhood neighborhood) {
+  invalidateSpeculation();
   grid_.setNeighborhood(neighborhood);
+  resetCycleDetection();
+  settingsChangedLocked();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
 }
 
 // Changes boundary behavior for future steps
 void Engine::setBoundary(Boundary boundary) {
   std::lock_guard<std::mutex> lock(mtx_);
+  setBoundaryLocked(boundary);
+}
+
+void Engine::setBoundaryLocked(Boundary boundary) {
+  invalidateSpeculation();
   grid_.setBoundary(boundary);
+  resetCycleDetection();
+  settingsChangedLocked();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
 }
 
 // Swaps active rule at runtime
 void Engine::setRule(std::unique_ptr<Rule> rule) {
   std::lock_guard<std::mutex> lock(mtx_);
-  rule_ = std::move(rule);
+  setRuleLocked(std::move(rule));
 }
 
-// Enables/disables distance preprocessing
-void Engine::setCalculatingDistances(bool calculating) {
-  calculating_distances_.store(calculating, std::memory_order_relaxed);
+void Engine::setRuleLocked(std::unique_ptr<Rule> rule) {
+  invalidateSpeculation();
+  rule_ = std::move(rule);
+  grid_.invalidateActiveBand();
+
+  // Generations of a rule that can't promise replays have to be stored
+  if (!rule_->isDeterministic()) history_mode_ = HistoryMode::Full;
+  converged_iteration_.reset();
+  resetCycleDetection();
+  settingsChangedLocked();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
 }
 
-Rule& Engine::getRule() const {
-  return *rule_;
+// Changes the active rule's parameters (Rule::setParameters) from the current generation on
+bool Engine::setRuleParameters(const std::string& parameters) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  if (!rule_->setParameters(parameters)) return false;
+
+  grid_.invalidateActiveBand();
+  converged_iteration_.reset();
+  resetCycleDetection();
+  settingsChangedLocked();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
+  return true;
 }
 
-bool Engine::isCalculatingDistances() const {
-  return calculating_distances_.load(std::memory_order_relaxed);
+// The current generation is the last one of the old settings: the generations after it are dropped, and it is kept
+// stored so replays of the ones stepped next start from it
+void Engine::settingsChangedLocked() {
+  const std::size_t iteration = iteration_.load(std::memory_order_relaxed);
+  if (iteration >= history_.size()) return;
+
+  if (history_.has(iteration)) {
+    history_.truncate(iteration + 1);
+  } else {
+    history_.truncate(iteration);
+    history_.push(std::as_const(grid_).getGridValues());
+  }
+  history_.pin(iteration);
+  history_.setSettingsBarrier(iteration);
 }
 
-// Injects app-specific distance logic without hardcoding it into core
-void Engine::setDistanceCalculator(std::function<void(std::vector<uint8_t>&, std::size_t, std::size_t, Neighborhood, Boundary)> calculator) {
-  std::lock_guard<std::mutex> lock(mtx_);
-  distance_calculator_ = calculator;
+Rule& Engine::getRule() const {
+  return *rule_;
 }
 
 // Clears distance bits while preserving the rest of each cell
 void Engine::resetDistances() {
   std::lock_guard<std::mutex> lock(mtx_);
 
-  std::vector<uint8_t> reset_grid = grid_.getGridValues();
+  std::vector<uint8_t> reset_grid = std::as_const(grid_).getGridValues();
   for (auto& cell : reset_grid) {
     cell = static_cast<uint8_t>(cell & 0b11110011);
   }
 
+  invalidateSpeculation();
   grid_.setGridValues(reset_grid);
-  setCalculatingDistances(false);
+  resetCycleDetection();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
 }
 
 // Returns grid copy for read-only style usage
 Grid Engine::getGridConst() const {
   return grid_;
 }
+
+std::shared_ptr<const GridSnapshot> Engine::getSnapshot() const {
+#if defined(__cpp_lib_atomic_shared_ptr)
+  return snapshot_.load(std::memory_order_acquire);
+#else
+  return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+#endif
+}
+
+void Engine::refreshSnapshot() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  publishSnapshot(iteration_.load(std::memory_order_relaxed));
+}
+
+// Fills a buffer no reader holds anymore (so steady stepping doesn't allocate) and swaps it in
+void Engine::publishSnapshot(std::size_t iteration) {
+  // Every state change is published, so edits and rewinds reach the recording here
+  recordFrameLocked(iteration);
+
+  std::shared_ptr<GridSnapshot> next;
+  for (const auto& pooled : snapshot_pool_) {
+    // Only the pool refers to it: not published anymore and every reader let go of it
+    if (pooled.use_count() == 1) {
+      next = pooled;
+      break;
+    }
+  }
+
+  if (next) {
+    // Pairs with the readers' reference release, their last reads happen before the buffer is rewritten
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } else {
+    next = std::make_shared<GridSnapshot>();
+    if (snapshot_pool_.size() < SNAPSHOT_BUFFERS) {
+      snapshot_pool_.push_back(next);
+    } else {
+      snapshot_pool_[snapshot_next_++ % SNAPSHOT_BUFFERS] = next; // the held buffer lives on with its readers
+    }
+  }
+
+  const auto& cells = std::as_const(grid_).getGridValues();
+  next->width = grid_.getWidth();
+  next->height = grid_.getHeight();
+  next->iteration = iteration;
+  next->boundary = grid_.getBoundary();
+  next->neighborhood = grid_.getNeighborhood();
+  next->hash = grid_.getHash();
+  next->rule = rule_->getName();
+  next->rule_parameters = rule_->getParameters();
+  next->cells.assign(cells.begin(), cells.end());
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+  snapshot_.store(std::move(next), std::memory_order_release);
+#else
+  std::atomic_store_explicit(&snapshot_, std::shared_ptr<const GridSnapshot>(std::move(next)), std::memory_order_release);
+#endif
+}
+
+// Starts (or resumes) filling the buffer from the last speculated generation
+void Engine::speculate() {
+  if (running_.load()) return;
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  const std::size_t iteration = iteration_.load(std::memory_order_relaxed);
+
+  // Before the first step the rule hasn't been set up for the run (Rule::beginRun)
+  if (iteration == 0 || speculation_depth_ == 0 || !rule_->isDeterministic()) return;
+
+  std::unique_lock<std::mutex> spec_lock(spec_mtx_);
+  if (speculating_) return;
+  if (spec_base_ != iteration) {
+    speculated_.clear();
+    spec_bytes_ = 0;
+    spec_base_ = iteration;
+  }
+  if (speculated_.size() >= speculation_depth_ || spec_bytes_ >= speculation_memory_) return;
+
+  Grid start = speculated_.empty() ? grid_ : speculated_.back();
+  const uint64_t epoch = spec_epoch_;
+  const std::size_t depth = speculation_depth_;
+  const std::size_t memory = speculation_memory_;
+  const std::size_t threads = speculation_threads_;
+  speculating_ = true;
+  spec_lock.unlock();
+
+  // Not speculating anymore, so the last thread is done (or about to return)
+  if (speculator_.joinable()) speculator_.join();
+
+  speculator_ = std::jthread([this, grid = std::move(start), epoch, depth, memory, threads](std::stop_token stoken) mutable {
+    parallel_thread_cap = threads;
+
+    while (!stoken.stop_requested()) {
+      grid.step(*rule_);
+      grid.setIteration(grid.getIteration() + 1);
+
+      std::lock_guard<std::mutex> lock(spec_mtx_);
+      if (epoch != spec_epoch_) break;
+
+      spec_bytes_ += speculation_bytes(grid);
+      speculated_.push_back(grid);
+      spec_cv_.notify_all();
+      if (speculated_.size() >= depth || spec_bytes_ >= memory) break;
+    }
+
+    std::lock_guard<std::mutex> lock(spec_mtx_);
+    speculating_ = false;
+    spec_cv_.notify_all();
+  });
+}
+
+void Engine::setSpeculationLimits(std::size_t depth, std::size_t memory_bytes, std::size_t threads) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  invalidateSpeculation();
+  speculation_depth_ = depth;
+  speculation_memory_ = memory_bytes;
+  speculation_threads_ = std::max<std::size_t>(threads, 1);
+}
+
+void Engine::stopSpeculation(bool discard) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  stopSpeculationLocked();
+  if (discard) invalidateSpeculation();
+}
+
+void Engine::stopSpeculationLocked() {
+  if (speculator_.joinable()) {
+    speculator_.request_stop();
+    speculator_.join();
+  }
+}
+
+std::size_t Engine::getSpeculatedCount() {
+  std::lock_guard<std::mutex> lock(spec_mtx_);
+  return speculated_.size();
+}
+
+void Engine::invalidateSpeculation() {
+  // A thread still stepping the old generations would go on using the rule while the engine changes or steps it
+  stopSpeculationLocked();
+
+  std::lock_guard<std::mutex> lock(spec_mtx_);
+  ++spec_epoch_;
+  speculated_.clear();
+  spec_bytes_ = 0;
+  spec_base_ = NO_SPECULATION;
+  spec_cv_.notify_all();
+}
+
+bool Engine::takeSpeculated(std::size_t iteration) {
+  std::unique_lock<std::mutex> lock(spec_mtx_);
+  if (spec_base_ != iteration) return false;
+
+  // The generation in progress is the one needed: waiting for it is never slower than computing it again
+  spec_cv_.wait(lock, [&] { return !speculated_.empty() || !speculating_ || spec_base_ != iteration; });
+  if (speculated_.empty() || spec_base_ != iteration) return false;
+
+  grid_ = std::move(speculated_.front());
+  speculated_.pop_front();
+  spec_bytes_ -= speculation_bytes(grid_);
+  spec_base_ = iteration + 1;
+  return true;
+}
@@ -3,11 +3,145 @@
 #include "grid.hpp"
 #include "rule.hpp"
 #include "rule_registry.hpp"
+#include "history.hpp"
+#include "mpsc_queue.hpp"
+#include "recording_file.hpp"
+#include <algorithm>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <thread>
-#include <functional>
 #include <memory>
+#include <optional>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+#include <variant>
+
+// One cell write of an edit batch (see Engine::editInput)
+struct CellEdit {
+  std::size_t x;
+  std::size_t y;
+  uint8_t state;
+};
+
+// Commands Engine::post queues for the stepping thread (besides CellEdit)
+struct RegionFill {
+  std::size_t x;
+  std::size_t y;
+  std::size_t width;
+  std::size_t height;
+  uint8_t state;
+};
+
+// Row-major block of cells written with its top left corner at (x, y), clipped at the grid edges
+struct PatternStamp {
+  std::size_t x;
+  std::size_t y;
+  std::size_t width;
+  std::vector<uint8_t> cells;
+  std::vector<uint8_t> mask = {}; // optional, same layout as cells: only cells where it is nonzero are written
+};
+
+struct BoundaryChange {
+  Boundary boundary;
+};
+
+struct NeighborhoodChange {
+  Neighborhood neighborhood;
+};
+
+struct RuleChange {
+  std::unique_ptr<Rule> rule;
+};
+
+struct GridResize {
+  std::size_t width;
+  std::size_t height;
+};
+
+// Engine::transformGrid
+enum class GridTransform : uint8_t {
+  RotateClockwise, RotateCounterclockwise, Rotate180, FlipHorizontal, FlipVertical
+};
+
+using EngineCommand = std::variant<CellEdit, RegionFill, PatternStamp, BoundaryChange, NeighborhoodChange, RuleChange, GridResize>;
+
+// Still or periodic behaviour detected in the current run (see Engine::getCycle)
+struct CycleInfo {
+  std::size_t start;  // first iteration of the repeating part
+  std::size_t period; // generations per repetition, 1 for a fixed point
+};
+
+// Immutable copy of a completed generation, published by the engine after every change (see Engine::getSnapshot)
+struct GridSnapshot {
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::size_t iteration = 0;
+  Boundary boundary = Boundary::Wrap;
+  Neighborhood neighborhood = Neighborhood::Moore;
+  uint64_t hash = 0;          // Grid::getHash of the cells
+  std::string rule;           // Rule::getName and Rule::getParameters of the rule as of this generation
+  std::string rule_parameters;
+  std::vector<uint8_t> cells; // row-major
+};
+
+// How Engine::stepAsync runs a batch
+struct StepOptions {
+  // false: only the batch's last generation is stored, the ones before stay unrecorded
+  // Ignored for rules that aren't deterministic, whose generations couldn't be recomputed
+  bool record_all = true;
+  // Called from the stepping thread every time the batch hands the engine back (about TURBO_PUBLISH_RATE times a second)
+  std::function<void(std::size_t done, std::size_t total)> on_progress;
+};
+
+// Progress and control of a batch started by Engine::stepAsync; copies refer to the same batch
+// A default constructed handle stands for no batch (finished, nothing done)
+class StepHandle {
+public:
+  std::size_t getTotal() const { return state_ ? state_->total : 0; }
+  std::size_t getDone() const { return state_ ? state_->done.load(std::memory_order_relaxed) : 0; }
+  float getProgress() const { return getTotal() ? static_cast<float>(getDone()) / static_cast<float>(getTotal()) : 1.0f; }
+  bool isFinished() const { return !result_.valid() || result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+  // Stops the batch after the generation in progress
+  void cancel() { if (state_) state_->cancelled.store(true, std::memory_order_relaxed); }
+
+  // Blocks until the batch ended; generations it advanced
+  std::size_t wait() const { return result_.valid() ? result_.get() : 0; }
+
+private:
+  friend class Engine;
+
+  struct State {
+    std::size_t total = 0;
+    std::atomic<std::size_t> done = 0;
+    std::atomic<bool> cancelled = false;
+  };
+
+  std::shared_ptr<State> state_;
+  std::shared_future<std::size_t> result_;
+};
+
+// Which generations Engine keeps in its history
+enum class HistoryMode : uint8_t {
+  Full,        // every generation
+  Checkpoints, // every K-th generation, rewinding recomputes the rest
+  Exponential, // checkpoints thinning out with age, so their count grows with the log of the run length
+  Count
+};
+
+inline const char* historyModeToString(HistoryMode mode) {
+  switch (mode) {
+    case HistoryMode::Full: return "Every generation";
+    case HistoryMode::Checkpoints: return "Checkpoints";
+    case HistoryMode::Exponential: return "Exponential checkpoints";
+    default: return "Unknown";
+  }
+}
 
 // Manages simulation lifecycle (threading, stepping, history, etc.)
 // Acts as bridge between UI and core grid/rule logic
@@ -22,7 +156,20 @@ public:
   // Advances one step (thread-safe wrapper around Grid::step)
   void step();
 
+  // Advances up to `generations` steps in one call, using the rule's whole-grid shortcut when it has one
+  // Only the final state is recorded, the skipped generations stay empty in history
+  // Returns how many generations were advanced (less than asked only if the rule reached a fixed point)
+  std::size_t fastForward(std::size_t generations);
+
+  // Runs `generations` steps on the background thread and returns right away
+  // The engine lock is taken once per chunk of about one display frame rather than per generation, snapshots are
+  // published per chunk; the batch ends early on cancel(), stop() (Pause) or when stopping on convergence / cycles
+  // Stops the background loop first; isRunning() is true while the batch runs
+  StepHandle stepAsync(std::size_t generations, StepOptions options = {});
+
   // Starts background simulation loop (uses jthread)
+  // Steps are scheduled against steady_clock deadlines, so the rate holds at getSpeed() however long a step takes
+  // (up to the point where steps alone take longer); speed and mode changes wake the loop right away
   void start();
 
   // Stops simulation loop
@@ -31,6 +178,37 @@ public:
   // Convenience toggle for UI
   void toggleRunning();
 
+  // Whether the background loop is still stepping (it ends on its own when stopping on convergence or cycles)
+  bool isRunning() const;
+
+  // Generation at which the rule reported convergence (Rule::hasConverged) in the current run, if it has
+  std::optional<std::size_t> getConvergedIteration();
+
+  // When on, the background loop and fastForward stop at the generation the rule reports convergence
+  void setStopOnConvergence(bool stop) { stop_on_convergence_.store(stop, std::memory_order_relaxed); }
+  bool isStoppingOnConvergence() const { return stop_on_convergence_.load(std::memory_order_relaxed); }
+
+  // Headless batch runs: steps (recording history) until the rule reports convergence or max_generations passed
+  // Returns the iteration convergence was reported at, nothing if it wasn't within the limit
+  std::optional<std::size_t> runUntilConverged(std::size_t max_generations);
+
+  // Cycle detection: every generation is indexed by its grid hash (Grid::getHash) and the rule's time phase
+  // (Rule::timePhase); the first repeat of both is the cycle. Repeats are checked against recorded frames where they exist
+  std::optional<CycleInfo> getCycle();
+
+  // Called once when a cycle is detected, from the thread that stepped into it (engine lock not held)
+  void setCycleCallback(std::function<void(const CycleInfo&)> callback);
+
+  // When on, the background loop and fastForward stop once the run entered a fixed point or cycle
+  void setStopOnCycle(bool stop) { stop_on_cycle_.store(stop, std::memory_order_relaxed); }
+  bool isStoppingOnCycle() const { return stop_on_cycle_.load(std::memory_order_relaxed); }
+
+  // Cells the last stepped generation changed
+  std::size_t getLastChangeCount() const { return last_changes_.load(std::memory_order_relaxed); }
+
+  // Hash of the current grid (see Grid::getHash)
+  uint64_t getStateHash();
+
   // Reset simulation to initial state (clears history and resets iteration counter) but keeps users 0th iteration meaning the drawn input
   void reset();
 
@@ -43,24 +221,86 @@ public:
   // Returns a copy (safe but potentially expensive)
   Grid getGridConst() const;
 
+  // Latest published generation; lock-free and consistent, so readers (rendering, saving, stats) neither copy the
+  // grid nor wait for a step in progress. The snapshot stays valid (and unchanged) for as long as it is held
+  std::shared_ptr<const GridSnapshot> getSnapshot() const;
+
+  // Republishes the grid after it was changed directly through getGrid() (paused editing)
+  void refreshSnapshot();
+
+  static constexpr std::size_t SNAPSHOT_BUFFERS = 3; // recycled snapshot buffers, more are allocated while readers hold them
+
   // Control simulation speed (steps per second)
   void setSpeed(double speed);
   double getSpeed() const;
 
+  // Max throughput: the background loop ignores the speed and steps back to back, publishing snapshots only at
+  // TURBO_PUBLISH_RATE; with skip_history it advances in fastForward batches that only record their last generation
+  void setMaxThroughput(bool on, bool skip_history = false);
+  bool isMaxThroughput() const { return max_throughput_.load(std::memory_order_relaxed); }
+  bool isSkippingHistory() const { return turbo_skip_history_.load(std::memory_order_relaxed); }
+
+  static constexpr double TURBO_PUBLISH_RATE = 60.0;     // snapshots per second in max throughput mode
+  static constexpr std::size_t MAX_TURBO_BATCH = 1 << 16; // generations per fastForward batch at most
+  static constexpr std::size_t MAX_CATCH_UP_TICKS = 4;    // a loop further behind drops the backlog instead of bursting
+
   // Access current rule (owned by engine)
   Rule& getRule() const;
 
   // Current iteration counter (mirrors grid but tracked separately)
   std::size_t getIteration() const;
 
-  // Full history of grid states (can get big fast so be careful of that, but it isnt usually an issue)
-  const std::vector<std::vector<uint8_t>>& getHistory();
+  // Full history of grid states (keyframes + deltas, see History)
+  // Not synchronized once returned: only for use while the engine isn't stepping (getSnapshot for the current state)
+  const History& getHistory();
+
+  // Resident / spilled bytes and page-ins of the history (see History)
+  HistoryStats getHistoryStats();
+
+  // Memory budget for recorded generations (0 = unlimited), older ones spill to a scratch file in `directory`
+  // (system temp directory when empty) beyond it
+  void setHistoryBudget(std::size_t bytes);
+  void setHistorySpillDirectory(const std::filesystem::path& directory);
+  std::size_t getHistoryBudget();
 
-  // Access specific snapshot
-  const std::vector<uint8_t>& getStateAtIteration(std::size_t iteration);
+  // Sparse history: only checkpoints are stored, goToIteration/stepBack recompute from the nearest earlier one
+  // interval 0 picks K automatically from the measured step time and the history budget (see checkpointInterval)
+  // Refused (false) for rules that aren't deterministic (Rule::isDeterministic); affects generations stepped from now on
+  bool setHistoryMode(HistoryMode mode, std::size_t interval = 0);
+  HistoryMode getHistoryMode();
+
+  // Checkpoint spacing currently in effect
+  std::size_t getCheckpointInterval();
+
+  static constexpr double REWIND_TARGET_SECONDS = 0.05;  // automatic K keeps replaying one interval about this long
+  static constexpr std::size_t MAX_AUTO_INTERVAL = 4096;
+  static constexpr std::size_t EXPONENTIAL_DENSITY = 8;  // exponential mode: checkpoints per doubling of age
+
+  // Copy of a recorded generation (decoded on demand; History's decode cache is shared, so no reference into it leaves the lock)
+  std::vector<uint8_t> getStateAtIteration(std::size_t iteration);
 
   // Replace current grid state
   void setGridValues(const std::vector<uint8_t>& new_grid_values);
+  void setGridValues(std::vector<uint8_t>&& new_grid_values);
+
+  // Queues an edit or config change without taking the engine lock (lock-free, any thread)
+  // A running engine applies everything queued between two generations, all at once; otherwise it is applied right
+  // away. Cell edits (paints, fills, stamps) replace the current generation in history like setGridValues, so the
+  // recorded frame only differs from the unedited one where the edit wrote (the history stores deltas)
+  void post(EngineCommand command);
+
+  // Edits the initial state (history root) and recomputes every recorded generation up to the current one
+  // Each generation is replayed against the recorded one (Grid::replayStep), so only what the edit actually reaches gets
+  // recomputed (e.g. Convex Hull seeds added or removed on an already computed hull); the result is the same as
+  // editing the initial state, resetting and stepping back to the current iteration
+  // Assumes the recorded history was produced by the current rule and settings
+  void editInput(const std::vector<CellEdit>& edits);
+
+  // Verification switch: when on, editInput also recomputes from scratch and compares both results
+  // On a mismatch it keeps the recomputed result and counts it
+  void setVerifyInputEdits(bool verify) { verify_input_edits_ = verify; }
+  bool isVerifyingInputEdits() const { return verify_input_edits_; }
+  std::size_t getInputEditMismatches() const { return input_edit_mismatches_.load(std::memory_order_relaxed); }
 
   // Runtime config changes
   void setNeighborhood(Neighborhood neighborhood);
@@ -69,32 +309,106 @@ public:
   // Swap rule dynamically
   void setRule(std::unique_ptr<Rule> rule);
 
-  // Toggle special mode (likely modifies how step behaves)
-  void setCalculatingDistances(bool calculating);
-  bool isCalculatingDistances() const;
+  // Changes the active rule's parameters (Rule::setParameters); false when the rule rejects them
+  // Like the other settings, the change applies from the current generation on, and drops the ones recorded after it
+  bool setRuleParameters(const std::string& parameters);
 
-  // Clears any stored distance data
+  // Clears any stored distance data (Convex Hull distance bits) so other rules do not inherit them
   void resetDistances();
 
   // Navigate simulation history backwards
   void stepBack(std::size_t steps = 1);
 
-  // Jump to specific iteration if available in history
+  // Jump to specific iteration of the recorded run
+  // Generations that weren't stored (sparse history, fastForward) are recomputed from the nearest earlier stored one,
+  // which needs a deterministic rule
   bool goToIteration(std::size_t iteration);
 
-  // Inject custom distance computation (pluggable behavior) usef only for convex hull for now
-  // WARNING: here is an design issue: rules currently dont carry any information if they need any distance calculation or not
-  // so forexapmle for convex hull there is in renderer a check if the rule is convex. This is certainly a design flaw so if any progress will be made on this in the future this is a first task on the todo list.
-  void setDistanceCalculator(std::function<void(std::vector<uint8_t>&, std::size_t, std::size_t, Neighborhood, Boundary)> calculator);
-  
   // Resize grid (likely resets or invalidates history)
   void resizeGrid(std::size_t new_width, std::size_t new_height);
 
-  ~Engine() = default;
+  // Whole grid reshapes (Grid::crop, pad, rotate90, rotate180, flipHorizontal, flipVertical); like resizeGrid they
+  // start a new run from the reshaped grid
+  void cropGrid(std::size_t x, std::size_t y, std::size_t width, std::size_t height);
+  void padGrid(std::size_t left, std::size_t top, std::size_t right, std::size_t bottom);
+  void transformGrid(GridTransform transform);
+
+  // Block of the current generation (Grid::copyRegion), pasted back with a PatternStamp
+  std::vector<uint8_t> copyRegion(std::size_t x, std::size_t y, std::size_t width, std::size_t height);
+
+  // Speculation while paused: computes the generations after the current one on a background thread, so the next
+  // step()/stepAsync takes them from the buffer instead of computing (waiting for the one in progress if needed)
+  // Meant to be called whenever the app is idle (the UI does every paused frame); does nothing while it's already
+  // running, the buffer is full, the engine is stepping, before the first step (run setup) or for rules that aren't
+  // deterministic. Edits, rewinds and config changes drop what was speculated
+  void speculate();
+
+  // Generations at most, memory cap for them and parallel_for threads the speculation may use (0 depth turns it off)
+  void setSpeculationLimits(std::size_t depth, std::size_t memory_bytes, std::size_t threads);
+
+  // Stops speculation, keeping what it finished unless `discard`; call before changing the rule's own settings
+  // (getRule() setters), with discard when the setting changes what the next generations are
+  void stopSpeculation(bool discard = false);
+
+  // Generations ready in the speculation buffer
+  std::size_t getSpeculatedCount();
+
+  static constexpr std::size_t DEFAULT_SPECULATION_DEPTH = 16;
+  static constexpr std::size_t DEFAULT_SPECULATION_MEMORY = std::size_t{64} << 20;
+
+  // Sibling timeline starting at `iteration` of this run (must be recorded or recomputable, see goToIteration)
+  // The fork shares every history frame up to there (see History::share), so forking is cheap however long the run
+  // was; both engines then step, rewind and run independently (and concurrently) without affecting each other
+  // `rule` replaces the fork's rule (e.g. trying another rule on an intermediate hull); by default it gets a fresh
+  // instance of the current one, settings made through the rule's own setters aren't carried over
+  // Returns nullptr when the generation can't be restored
+  std::unique_ptr<Engine> fork(std::size_t iteration, std::unique_ptr<Rule> rule = nullptr);
+
+  // Cells (row-major indices) where the current grids of this engine and `other` differ
+  // Equal grid hashes and equal rows are skipped without a per-cell comparison
+  std::vector<std::size_t> diff(Engine& other);
+
+  // First generation both timelines recorded and disagree on, nothing if they agree wherever both have frames
+  // Frames still shared since a fork are known to be equal without being decoded
+  std::optional<std::size_t> firstDivergence(Engine& other);
+
+  // Recording: streams the current generation and every one the run reaches after it into a recording file
+  // (recording_file::Writer), encoded and written on a background thread so stepping only pays for a copy
+  // Edits and rewinds are followed like in history, the file holds the run's timeline as it stands when stopped
+  // Settings are recorded as of the start; resizing the grid stops the recording. False when the file can't be created
+  bool startRecording(const std::filesystem::path& path);
+
+  // Writes the index and closes the file; false when not recording or a write failed
+  bool stopRecording();
+
+  bool isRecording();
+
+  // Generations recorded and bytes written so far (0 when not recording)
+  std::size_t getRecordedGenerations();
+  std::size_t getRecordingBytes();
+
+  // Joins the background threads before the members they use go away
+  ~Engine();
 
 private:
   std::jthread worker_; // background loop (auto-joins on destruction)
 
+  // Scheduling of the background loop: it waits for its next deadline here, changes wake it early
+  std::mutex schedule_mtx_;
+  std::condition_variable_any schedule_cv_;
+  uint64_t schedule_version_ = 0; // guarded by schedule_mtx_, bumped by every speed/mode change
+  std::atomic<bool> max_throughput_ = false;
+  std::atomic<bool> turbo_skip_history_ = false;
+
+  void wakeWorker();
+
+  // Steps one generation, publishing the snapshot only when asked (step() always does)
+  void advance(bool publish);
+
+  // One generation with mtx_ held: steps, records it (per history mode, or leaves it unrecorded when `record` is off),
+  // checks convergence and cycles; true when it just entered a cycle
+  bool stepLocked(bool record);
+
   std::mutex mtx_; // protects grid/history during concurrent access
 
   Grid grid_;
@@ -105,10 +419,99 @@ private:
 
   std::atomic<std::size_t> iteration_; // global iteration counter
 
-  std::vector<std::vector<uint8_t>> history_; // stores past states (memory-heavy)
-
-  std::atomic<bool> calculating_distances_{false}; // mode flag
-
-  // Optional injected algorithm (keeps engine flexible without hardcoding logic)
-  std::function<void(std::vector<uint8_t>&, std::size_t, std::size_t, Neighborhood, Boundary)> distance_calculator_;
+  std::atomic<bool> running_ = false;            // background loop active
+  std::atomic<bool> stop_on_convergence_ = false;
+  std::optional<std::size_t> converged_iteration_; // guarded by mtx_, cleared whenever a new run starts
+
+  // Checks the rule after a generation was stepped (mtx_ held)
+  void checkConvergence();
+
+  // Cycle detection state, guarded by mtx_
+  struct SeenState {
+    std::size_t iteration;
+    std::size_t phase;
+  };
+  std::unordered_map<uint64_t, SeenState> seen_states_; // hash + phase key -> first iteration with that state
+  std::optional<CycleInfo> cycle_;
+  std::function<void(const CycleInfo&)> cycle_callback_;
+  std::atomic<bool> stop_on_cycle_ = false;
+  std::atomic<std::size_t> last_changes_ = 0;
+
+  // Indexes the current generation (mtx_ held), true when it just closed a cycle
+  bool recordState(std::size_t iteration);
+  void resetCycleDetection();
+
+  History history_; // stores past states
+  HistoryMode history_mode_ = HistoryMode::Full;
+  std::size_t checkpoint_interval_ = 0; // 0 = automatic
+  double step_seconds_ = 0.0;           // moving average of Grid::step time, for the automatic interval
+
+  // Stores (or skips) the generation just stepped to, per history mode (mtx_ held)
+  void recordGeneration(std::size_t iteration);
+  std::size_t checkpointInterval() const;
+  void thinCheckpoints(std::size_t iteration);
+
+  // Restores the nearest stored generation before `iteration` into `grid` (holding generation `current`) and steps
+  // forward without recording (mtx_ held)
+  bool replayTo(Grid& grid, std::size_t current, std::size_t iteration);
+
+  bool verify_input_edits_ = false;
+  std::atomic<std::size_t> input_edit_mismatches_ = 0;
+
+  // Snapshot publishing: the current one is swapped atomically, the pool recycles buffers no reader holds anymore
+#if defined(__cpp_lib_atomic_shared_ptr)
+  std::atomic<std::shared_ptr<const GridSnapshot>> snapshot_;
+#else
+  std::shared_ptr<const GridSnapshot> snapshot_; // only accessed through std::atomic_load / std::atomic_store
+#endif
+  std::vector<std::shared_ptr<GridSnapshot>> snapshot_pool_; // guarded by mtx_
+  std::size_t snapshot_next_ = 0;
+
+  // Copies the grid (at generation `iteration`) into a snapshot and publishes it (mtx_ held)
+  void publishSnapshot(std::size_t iteration);
+
+  // Speculation: whole Grid copies (so the active band carries over), generation spec_base_ + 1 first
+  // speculator_ is guarded by mtx_, the rest by spec_mtx_ (taken after mtx_, the speculating thread never takes mtx_)
+  static constexpr std::size_t NO_SPECULATION = std::numeric_limits<std::size_t>::max();
+  std::jthread speculator_;
+  std::mutex spec_mtx_;
+  std::condition_variable spec_cv_;
+  std::deque<Grid> speculated_;
+  std::size_t spec_base_ = NO_SPECULATION;
+  std::size_t spec_bytes_ = 0;
+  uint64_t spec_epoch_ = 0;   // bumped by every invalidation, a speculating thread of an older epoch discards its work
+  bool speculating_ = false;
+  std::size_t speculation_depth_ = DEFAULT_SPECULATION_DEPTH;
+  std::size_t speculation_memory_ = DEFAULT_SPECULATION_MEMORY;
+  std::size_t speculation_threads_ = std::max<std::size_t>(std::thread::hardware_concurrency() / 2, 1);
+
+  MpscQueue<EngineCommand> commands_; // see post
+
+  // Applies everything posted so far (mtx_ held); true when anything was applied
+  bool applyCommandsLocked();
+
+  // Setter bodies shared with posted commands (mtx_ held)
+  void setNeighborhoodLocked(Neighborhood neighborhood);
+  void setBoundaryLocked(Boundary boundary);
+  void setRuleLocked(std::unique_ptr<Rule> rule);
+  void resizeGridLocked(std::size_t new_width, std::size_t new_height);
+  void reshapedLocked(); // the grid was resized or reshaped: it becomes generation 0 of a new run
+
+  // Ends the history at the current generation before a settings change (mtx_ held)
+  void settingsChangedLocked();
+
+  // Drops the speculated generations (the grid they started from changed) and stops the thread computing more (mtx_ held)
+  void invalidateSpeculation();
+  void stopSpeculationLocked(); // mtx_ held
+
+  // Replaces the grid with the speculated generation after `iteration`, if there is one (mtx_ held)
+  bool takeSpeculated(std::size_t iteration);
+
+  // Recording (guarded by mtx_); the last generation handed to it, so republishing an unchanged grid isn't copied again
+  std::unique_ptr<recording_file::Writer> recorder_;
+  std::size_t recorded_iteration_ = 0;
+  uint64_t recorded_hash_ = 0;
+
+  // Hands the current grid (generation `iteration`) to the recording, if there is one (mtx_ held)
+  void recordFrameLocked(std::size_t iteration);
 };
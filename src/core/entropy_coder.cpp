@@ -0,0 +1,148 @@
+#include "entropy_coder.hpp"
+#include <array>
+
+namespace {
+
+constexpr unsigned PROBABILITY_BITS = 11;
+constexpr uint16_t PROBABILITY_ONE = 1 << PROBABILITY_BITS;
+constexpr unsigned ADAPT_SHIFT = 5;
+constexpr uint32_t TOP = 1u << 24;
+constexpr std::size_t CONTEXTS = 16;
+
+// Bit tree per context: node 1 codes the top bit, node (1 << k | first k bits) the next one
+struct Model {
+  Model() { for (auto& tree : trees) tree.fill(PROBABILITY_ONE / 2); }
+
+  std::array<std::array<uint16_t, 256>, CONTEXTS> trees;
+};
+
+std::size_t context_of(uint8_t previous) {
+  return previous >> 4;
+}
+
+class Encoder {
+public:
+  explicit Encoder(std::vector<uint8_t>& out) : out_(out) {}
+
+  void bit(uint16_t& probability, unsigned value) {
+    const uint32_t bound = (range_ >> PROBABILITY_BITS) * probability;
+    if (value == 0) {
+      range_ = bound;
+      probability += (PROBABILITY_ONE - probability) >> ADAPT_SHIFT;
+    } else {
+      low_ += bound;
+      range_ -= bound;
+      probability -= probability >> ADAPT_SHIFT;
+    }
+    while (range_ < TOP) {
+      range_ <<= 8;
+      shiftLow();
+    }
+  }
+
+  void finish() {
+    for (int i = 0; i < 5; ++i) shiftLow();
+  }
+
+private:
+  // Bytes go out one behind, a carry out of low_ may still have to ripple through a run of 0xFF
+  void shiftLow() {
+    if (static_cast<uint32_t>(low_) < 0xFF000000u || (low_ >> 32) != 0) {
+      const uint8_t carry = static_cast<uint8_t>(low_ >> 32);
+      uint8_t pending = cache_;
+      do {
+        out_.push_back(static_cast<uint8_t>(pending + carry));
+        pending = 0xFF;
+      } while (--cache_size_ != 0);
+      cache_ = static_cast<uint8_t>(low_ >> 24);
+    }
+    ++cache_size_;
+    low_ = (low_ & 0x00FFFFFFu) << 8;
+  }
+
+  std::vector<uint8_t>& out_;
+  uint64_t low_ = 0;
+  uint32_t range_ = 0xFFFFFFFFu;
+  uint8_t cache_ = 0;
+  std::size_t cache_size_ = 1;
+};
+
+class Decoder {
+public:
+  Decoder(const uint8_t* data, std::size_t size) : data_(data), end_(data + size) {
+    for (int i = 0; i < 5; ++i) code_ = (code_ << 8) | next();
+  }
+
+  unsigned bit(uint16_t& probability) {
+    const uint32_t bound = (range_ >> PROBABILITY_BITS) * probability;
+    unsigned value;
+    if (code_ < bound) {
+      range_ = bound;
+      probability += (PROBABILITY_ONE - probability) >> ADAPT_SHIFT;
+      value = 0;
+    } else {
+      code_ -= bound;
+      range_ -= bound;
+      probability -= probability >> ADAPT_SHIFT;
+      value = 1;
+    }
+    while (range_ < TOP) {
+      range_ <<= 8;
+      code_ = (code_ << 8) | next();
+    }
+    return value;
+  }
+
+  // Reading past the end means the input was cut short (the encoder's flush covers every byte the decoder needs)
+  bool overrun() const { return overrun_; }
+
+private:
+  uint8_t next() {
+    if (data_ < end_) return *data_++;
+    overrun_ = true;
+    return 0;
+  }
+
+  const uint8_t* data_;
+  const uint8_t* end_;
+  uint32_t code_ = 0;
+  uint32_t range_ = 0xFFFFFFFFu;
+  bool overrun_ = false;
+};
+
+}
+
+namespace entropy_coder {
+
+void encode(const uint8_t* data, std::size_t size, std::vector<uint8_t>& out) {
+  Model model;
+  Encoder encoder(out);
+  uint8_t previous = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    auto& tree = model.trees[context_of(previous)];
+    unsigned node = 1;
+    for (int b = 7; b >= 0; --b) {
+      const unsigned value = (data[i] >> b) & 1;
+      encoder.bit(tree[node], value);
+      node = (node << 1) | value;
+    }
+    previous = data[i];
+  }
+  encoder.finish();
+}
+
+bool decode(const uint8_t* data, std::size_t data_size, uint8_t* out, std::size_t size) {
+  Model model;
+  Decoder decoder(data, data_size);
+  uint8_t previous = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    auto& tree = model.trees[context_of(previous)];
+    unsigned node = 1;
+    for (int b = 0; b < 8; ++b) node = (node << 1) | decoder.bit(tree[node]);
+    out[i] = static_cast<uint8_t>(node);
+    previous = out[i];
+  }
+  return !decoder.overrun();
+}
+
+} // namespace entropy_coder
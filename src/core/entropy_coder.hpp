@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Adaptive binary range coder over bytes (the LZMA scheme: 11 bit probabilities in a bit tree per byte)
+// Each byte is coded in the context of the upper half of the byte before it, so the alternating fields of run-length
+// streams (run lengths, cell values) get separate statistics. The model starts fresh on every call, so each buffer
+// decodes on its own
+namespace entropy_coder {
+
+// Appends the coded form of [data, data + size) to `out`
+void encode(const uint8_t* data, std::size_t size, std::vector<uint8_t>& out);
+
+// Decodes exactly `size` bytes into `out`; false when the input is too short for them
+bool decode(const uint8_t* data, std::size_t data_size, uint8_t* out, std::size_t size);
+
+} // namespace entropy_coder
@@ -1,8 +1,25 @@
 #include "grid.hpp"
 #include "rule_context.hpp"
-#include <thread>
+#include "parallel.hpp"
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+// Per-position key of the grid hash (splitmix64 finalizer), a cell adds key * state
+inline uint64_t cell_key(std::size_t i) {
+  uint64_t z = static_cast<uint64_t>(i) + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// Square tiles of the blocked transposes (a tile's source and destination rows both stay in L1)
+constexpr std::size_t TRANSPOSE_TILE = 64;
+
+}
 
 // Creates grid storage and fills it with the default state
 Grid::Grid(std::size_t width, std::size_t height, uint8_t default_state, Boundary boundary, Neighborhood neighborhood)
@@ -14,67 +31,298 @@ Grid::Grid(std::size_t width, std::size_t height, uint8_t default_state, Boundar
 void Grid::step(const Rule& rule) {
   if (new_cells_.size() != cells_.size()) {
     new_cells_.resize(cells_.size());
+    band_rule_ = nullptr;
   }
 
-  // Split rows across hardware threads when possible
-  std::size_t thread_count = std::thread::hardware_concurrency();
-  if (thread_count == 0) {
-    thread_count = 1;
+  // Active band: a cell can only change if something within the rule's radius changed in the previous step
+  // Cells outside it already hold their next value in new_cells_ (last generation's value, or last pre-step result),
+  // which only holds while the previous step ran the same rule and nothing edited the grid since
+  const bool banded = band_rule_ == &rule && rule.hasActiveBand() && !rule.requiresFullStep(*this);
+  const auto apply_stage = static_cast<Stage>(&Rule::apply); // cast picks the context overload
+
+  if (rule.hasPreStep()) {
+    // Rules with a pre-step get an extra stage through the same double buffer
+    const bool pre_banded = banded && collectBand(changed_, rule.preStepRadius(), band_);
+    if (!pre_banded && rule.hasActiveBand()) {
+      // Whole grid: both stages in one pass (the radii say how far apply has to trail the pre-step)
+      runFusedStages(rule, apply_stage, changed_);
+    } else {
+      runStage(rule, &Rule::preStep, pre_banded ? &band_ : nullptr, false, stage_changed_);
+
+      const bool apply_banded = banded && collectBand(stage_changed_, rule.applyRadius(), band_);
+      runStage(rule, apply_stage, apply_banded ? &band_ : nullptr, false, changed_, true);
+    }
+  } else {
+    const bool apply_banded = banded && collectBand(changed_, rule.applyRadius(), band_);
+    runStage(rule, apply_stage, apply_banded ? &band_ : nullptr, true, changed_, true);
   }
 
-  thread_count = std::min(thread_count, height_);
-  const std::size_t rows_per_thread = (height_ + thread_count - 1) / thread_count;
+  last_changes_ = changed_.size();
+  band_rule_ = rule.hasActiveBand() ? &rule : nullptr;
+}
 
-  std::vector<std::thread> threads;
-  threads.reserve(thread_count);
+// Same stages as step, but cells far from `differing` simply take the recorded next generation
+void Grid::replayStep(const Rule& rule, const std::vector<uint8_t>& reference_next, std::vector<std::size_t>& differing) {
+  if (new_cells_.size() != cells_.size()) {
+    new_cells_.resize(cells_.size());
+  }
 
-  for (std::size_t t = 0; t < thread_count; ++t) {
-    const std::size_t y_begin = t * rows_per_thread;
-    const std::size_t y_end = std::min(y_begin + rows_per_thread, height_);
+  // changed_ won't describe this generation, so the next plain step evaluates everything
+  band_rule_ = nullptr;
+  hash_valid_ = false;
+
+  const bool local = rule.hasActiveBand();
+  const auto apply_stage = static_cast<Stage>(&Rule::apply);
+
+  if (rule.hasPreStep()) {
+    // The original run's pre-step results were never stored, so the pre-step is recomputed on everything the
+    // apply band reads (apply radius further out than the apply band itself)
+    const std::size_t apply_reach = rule.preStepRadius() + rule.applyRadius();
+    const bool pre_banded = local && collectBand(differing, apply_reach + rule.applyRadius(), band_);
+    runStage(rule, &Rule::preStep, pre_banded ? &band_ : nullptr, false, stage_changed_);
+
+    const bool apply_banded = local && collectBand(differing, apply_reach, band_);
+    std::copy(reference_next.begin(), reference_next.end(), new_cells_.begin());
+    runStage(rule, apply_stage, apply_banded ? &band_ : nullptr, false, differing);
+  } else {
+    const bool apply_banded = local && collectBand(differing, rule.applyRadius(), band_);
+    std::copy(reference_next.begin(), reference_next.end(), new_cells_.begin());
+    runStage(rule, apply_stage, apply_banded ? &band_ : nullptr, false, differing);
+  }
+}
 
-    if (y_begin >= y_end) {
-        break;
+// One pass over the grid: reads cells_, writes new_cells_, then swaps
+void Grid::runStage(const Rule& rule, Stage stage, const std::vector<std::size_t>* band, bool compare_with_input, std::vector<std::size_t>& changed, bool track_hash) {
+  changed.clear();
+  std::mutex changed_mutex;
+  track_hash = track_hash && hash_valid_;
+
+  const std::size_t count = band ? band->size() : cells_.size();
+  cell_updates_ += count;
+
+  // Split cells across hardware threads when possible (whole rows when there is no band)
+  parallel_for(count, [&](std::size_t begin, std::size_t end) {
+    // Thread-local context avoids sharing mutable x/y between workers
+    RuleContext ctx{*this, 0, 0, neighborhood_, boundary_};
+
+    // Reused per cell to avoid reallocating neighbor storage
+    std::vector<uint8_t> neighbors;
+    neighbors.reserve(8); // TODO: not always 8 once wider/custom neighborhoods matter this is safe for now since we only have moore and vonneumann but change later when we add more neighborhood types
+
+    std::vector<std::size_t> local_changed;
+    uint64_t local_hash = 0; // sums wrap around, so per-thread partial hashes combine in any order
+
+    // Position for the full pass, advanced cell by cell instead of dividing every index
+    std::size_t x = begin % width_;
+    std::size_t y = begin / width_;
+
+    for (std::size_t k = begin; k < end; ++k) {
+      std::size_t i = k;
+      if (band) {
+        i = (*band)[k];
+        ctx.x = i % width_;
+        ctx.y = i / width_;
+      } else {
+        ctx.x = x;
+        ctx.y = y;
+        if (++x == width_) {
+          x = 0;
+          ++y;
+        }
+      }
+
+      getNeighborsStatic(cells_, ctx.x, ctx.y, width_, height_, neighborhood_, boundary_, neighbors);
+
+      const uint8_t current_state = cells_[i];
+      const uint8_t previous = compare_with_input ? current_state : new_cells_[i];
+
+      // Rule reads old state and writes only this cell's next state
+      const uint8_t next_state = (rule.*stage)(current_state, ctx, neighbors);
+      new_cells_[i] = next_state;
+
+      if (next_state != previous) {
+        local_changed.push_back(i);
+        if (track_hash) local_hash += cell_key(i) * (static_cast<uint64_t>(next_state) - previous);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(changed_mutex);
+    changed.insert(changed.end(), local_changed.begin(), local_changed.end());
+    hash_ += local_hash;
+  });
+
+  // Swap buffers so all cells update at the same time
+  cells_.swap(new_cells_);
+}
+
+// Pre-step and apply over the whole grid in one pass: every thread takes a strip of rows, pre-steps it row by row and
+// applies each row as soon as the pre-step rows it reads are done, so the pre-step result is read back from cache
+// instead of in a second pass over memory. Rows within `lag` of a strip's edge read (or are read by) the neighbouring
+// strips, they are applied after all strips are pre-stepped
+void Grid::runFusedStages(const Rule& rule, Stage apply_stage, std::vector<std::size_t>& changed) {
+  const std::size_t lag = std::max({std::size_t{1}, rule.preStepRadius(), rule.applyRadius()});
+  const bool track_hash = hash_valid_;
+
+  stage_changed_.clear();
+  changed.clear();
+  cell_updates_ += 2 * cells_.size();
+
+  // Apply reads the pre-step result through the grid, so during the pass cells_ holds that and new_cells_ the input
+  // (the roles runStage gives them after its pre-step swap)
+  cells_.swap(new_cells_);
+
+  std::vector<std::size_t> deferred;
+  std::mutex mutex;
+
+  // One stage over whole rows [first, last): reads `input`, writes `output`, compares with what output held
+  auto run_rows = [&](Stage stage, const std::vector<uint8_t>& input, std::vector<uint8_t>& output, std::size_t first, std::size_t last,
+                      RuleContext& ctx, std::vector<uint8_t>& neighbors, std::vector<std::size_t>& local_changed, uint64_t* local_hash) {
+    for (std::size_t y = first; y < last; ++y) {
+      ctx.y = y;
+      for (std::size_t x = 0; x < width_; ++x) {
+        const std::size_t i = idx(x, y, width_);
+        ctx.x = x;
+        getNeighborsStatic(input, x, y, width_, height_, neighborhood_, boundary_, neighbors);
+
+        const uint8_t previous = output[i];
+        const uint8_t next_state = (rule.*stage)(input[i], ctx, neighbors);
+        output[i] = next_state;
+
+        if (next_state != previous) {
+          local_changed.push_back(i);
+          if (local_hash) *local_hash += cell_key(i) * (static_cast<uint64_t>(next_state) - previous);
+        }
+      }
+    }
+  };
+
+  auto merge = [&](const std::vector<std::size_t>& pre_changed, const std::vector<std::size_t>& apply_changed, uint64_t local_hash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stage_changed_.insert(stage_changed_.end(), pre_changed.begin(), pre_changed.end());
+    changed.insert(changed.end(), apply_changed.begin(), apply_changed.end());
+    hash_ += local_hash;
+  };
+
+  parallel_for(height_, [&](std::size_t begin, std::size_t end) {
+    RuleContext ctx{*this, 0, 0, neighborhood_, boundary_};
+    std::vector<uint8_t> neighbors;
+    neighbors.reserve(8);
+    std::vector<std::size_t> pre_changed;
+    std::vector<std::size_t> apply_changed;
+    uint64_t local_hash = 0;
+
+    // Rows [head, tail) only touch this strip, the rest waits for the other threads
+    const std::size_t head = std::min(end, begin + lag);
+    const std::size_t tail = std::max(head, end - std::min(end - begin, lag));
+
+    for (std::size_t y = begin; y < end; ++y) {
+      run_rows(&Rule::preStep, new_cells_, cells_, y, y + 1, ctx, neighbors, pre_changed, nullptr);
+
+      // Everything row y - lag reads is pre-stepped now, and later pre-step rows don't read it anymore
+      if (y >= head + lag && y - lag < tail) {
+        run_rows(apply_stage, cells_, new_cells_, y - lag, y - lag + 1, ctx, neighbors, apply_changed, track_hash ? &local_hash : nullptr);
+      }
     }
 
-    threads.emplace_back([&, y_begin, y_end]() {
-      // Thread-local context avoids sharing mutable x/y between workers
-      RuleContext ctx{*this, 0, 0, neighborhood_, boundary_};
+    merge(pre_changed, apply_changed, local_hash);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t y = begin; y < head; ++y) deferred.push_back(y);
+    for (std::size_t y = tail; y < end; ++y) deferred.push_back(y);
+  });
 
-      // Reused per cell to avoid reallocating neighbor storage
-      std::vector<uint8_t> neighbors;
-      neighbors.reserve(8); // TODO: not always 8 once wider/custom neighborhoods matter this is safe for now since we only have moore and vonneumann but change later when we add more neighborhood types
+  parallel_for(deferred.size(), [&](std::size_t begin, std::size_t end) {
+    RuleContext ctx{*this, 0, 0, neighborhood_, boundary_};
+    std::vector<uint8_t> neighbors;
+    neighbors.reserve(8);
+    std::vector<std::size_t> apply_changed;
+    uint64_t local_hash = 0;
 
-      for (std::size_t y = y_begin; y < y_end; ++y) {
-        const std::size_t row = y * width_;
+    for (std::size_t k = begin; k < end; ++k) {
+      run_rows(apply_stage, cells_, new_cells_, deferred[k], deferred[k] + 1, ctx, neighbors, apply_changed, track_hash ? &local_hash : nullptr);
+    }
 
-        for (std::size_t x = 0; x < width_; ++x) {
-          ctx.x = x;
-          ctx.y = y;
+    merge({}, apply_changed, local_hash);
+  });
 
-          getNeighborsStatic(cells_, x, y, width_, height_, neighborhood_, boundary_, neighbors);
+  // Same buffers as after runStage's apply swap: cells_ the new generation, new_cells_ the pre-step result
+  cells_.swap(new_cells_);
+}
+
+// Marks the square around every seed once and lists the marked cells
+bool Grid::collectBand(const std::vector<std::size_t>& seeds, std::size_t radius, std::vector<std::size_t>& band) {
+  band.clear();
+  band_mark_.resize(cells_.size(), 0);
+
+  // Past half the grid a plain full pass is cheaper than the bookkeeping
+  const std::size_t limit = cells_.size() / 2;
+  const long r = static_cast<long>(radius);
+  const long w = static_cast<long>(width_);
+  const long h = static_cast<long>(height_);
+  const bool wrap = boundary_ == Boundary::Wrap;
+
+  for (std::size_t seed : seeds) {
+    const long x = static_cast<long>(seed % width_);
+    const long y = static_cast<long>(seed / width_);
+
+    for (long dy = -r; dy <= r; ++dy) {
+      long ny = y + dy;
+      if (ny < 0 || ny >= h) {
+        if (!wrap) continue;
+        ny = ((ny % h) + h) % h;
+      }
 
-          const std::size_t i = row + x;
-          const uint8_t current_state = cells_[i];
+      for (long dx = -r; dx <= r; ++dx) {
+        long nx = x + dx;
+        if (nx < 0 || nx >= w) {
+          if (!wrap) continue;
+          nx = ((nx % w) + w) % w;
+        }
 
-          // Rule reads old state and writes only this cell's next state
-          new_cells_[i] = rule.apply(current_state, ctx, neighbors);
+        const std::size_t i = idx(static_cast<std::size_t>(nx), static_cast<std::size_t>(ny), width_);
+        if (!band_mark_[i]) {
+          band_mark_[i] = 1;
+          band.push_back(i);
         }
       }
-    });
+    }
+
+    if (band.size() > limit) break;
   }
 
-  for (auto& th : threads) {
-      th.join();
+  for (std::size_t i : band) {
+    band_mark_[i] = 0;
   }
 
-  // Swap buffers so all cells update at the same time
-  cells_.swap(new_cells_);
+  return band.size() <= limit;
+}
+
+uint64_t Grid::getHash() const {
+  if (!hash_valid_) {
+    hash_ = 0;
+    for (std::size_t i = 0; i < cells_.size(); ++i) {
+      if (cells_[i]) hash_ += cell_key(i) * cells_[i];
+    }
+    hash_valid_ = true;
+  }
+  return hash_;
+}
+
+std::size_t Grid::getLastChangeCount() const {
+  return last_changes_;
+}
+
+void Grid::invalidateActiveBand() {
+  band_rule_ = nullptr;
 }
 
 // Safe write: ignores out-of-bounds clicks/updates
 void Grid::setCell(std::size_t x, std::size_t y, uint8_t state) {
   if (x < width_ && y < height_) {
-    cells_[idx(x, y, width_)] = state;
+    const std::size_t i = idx(x, y, width_);
+    if (hash_valid_) hash_ += cell_key(i) * (static_cast<uint64_t>(state) - cells_[i]);
+    cells_[i] = state;
+    band_rule_ = nullptr;
   }
 }
 
@@ -88,6 +336,8 @@ uint8_t Grid::getCell(std::size_t x, std::size_t y) const {
 
 // Direct mutable access for UI/tools that need raw grid data
 std::vector<uint8_t>& Grid::getGridValues() {
+  band_rule_ = nullptr;
+  hash_valid_ = false;
   return cells_;
 }
 
@@ -95,6 +345,16 @@ std::vector<uint8_t>& Grid::getGridValues() {
 void Grid::setGridValues(const std::vector<uint8_t>& values) {
   if (values.size() == cells_.size()) {
     cells_ = values;
+    band_rule_ = nullptr;
+    hash_valid_ = false;
+  }
+}
+
+void Grid::setGridValues(std::vector<uint8_t>&& values) {
+  if (values.size() == cells_.size()) {
+    cells_ = std::move(values);
+    band_rule_ = nullptr;
+    hash_valid_ = false;
   }
 }
 
@@ -108,19 +368,171 @@ std::size_t Grid::getHeight() const {
 
 // Resizes storage; new cells default to dead
 void Grid::resize(std::size_t new_width, std::size_t new_height) {
-  width_ = new_width;
-  height_ = new_height;
-  cells_.resize(new_width * new_height, 0);
+  if (new_width == width_) {
+    // Rows keep their offsets, only the tail changes
+    cells_.resize(new_width * new_height, 0);
+    height_ = new_height;
+    band_rule_ = nullptr;
+    hash_valid_ = false;
+    return;
+  }
+
+  std::vector<uint8_t> resized(new_width * new_height, 0);
+  const std::size_t row = std::min(width_, new_width);
+  for (std::size_t y = 0; y < std::min(height_, new_height) && row > 0; ++y) {
+    std::memcpy(resized.data() + y * new_width, cells_.data() + y * width_, row);
+  }
+  replaceCells(std::move(resized), new_width, new_height);
+}
+
+std::vector<uint8_t> Grid::copyRegion(std::size_t x, std::size_t y, std::size_t w, std::size_t h) const {
+  std::vector<uint8_t> region(w * h, 0);
+  if (x >= width_ || y >= height_) return region;
+
+  const std::size_t row = std::min(w, width_ - x);
+  for (std::size_t r = 0; r < h && y + r < height_; ++r) {
+    std::memcpy(region.data() + r * w, cells_.data() + idx(x, y + r, width_), row);
+  }
+  return region;
+}
+
+void Grid::blit(const std::vector<uint8_t>& region, std::size_t region_width, std::size_t x, std::size_t y) {
+  if (region_width == 0 || x >= width_ || y >= height_) return;
+
+  const std::size_t rows = region.size() / region_width;
+  const std::size_t row = std::min(region_width, width_ - x);
+  for (std::size_t r = 0; r < rows && y + r < height_; ++r) {
+    writeRow(idx(x, y + r, width_), region.data() + r * region_width, row);
+  }
+  band_rule_ = nullptr;
+}
+
+void Grid::stamp(const std::vector<uint8_t>& region, std::size_t region_width, std::size_t x, std::size_t y, const std::vector<uint8_t>& mask) {
+  if (region_width == 0 || x >= width_ || y >= height_ || mask.size() < region.size()) return;
+
+  const std::size_t rows = region.size() / region_width;
+  const std::size_t row = std::min(region_width, width_ - x);
+  for (std::size_t r = 0; r < rows && y + r < height_; ++r) {
+    const uint8_t* src = region.data() + r * region_width;
+    const uint8_t* keep = mask.data() + r * region_width;
+    const std::size_t start = idx(x, y + r, width_);
+
+    // Masked-out cells keep their state, so the row is written in runs of masked-in cells
+    for (std::size_t k = 0; k < row;) {
+      while (k < row && !keep[k]) ++k;
+      const std::size_t run = k;
+      while (k < row && keep[k]) ++k;
+      if (k > run) writeRow(start + run, src + run, k - run);
+    }
+  }
+  band_rule_ = nullptr;
+}
+
+void Grid::fill(std::size_t x, std::size_t y, std::size_t w, std::size_t h, uint8_t state) {
+  if (x >= width_ || y >= height_) return;
+
+  const std::size_t row = std::min(w, width_ - x);
+  const std::vector<uint8_t> source(row, state);
+  for (std::size_t r = 0; r < h && y + r < height_; ++r) {
+    writeRow(idx(x, y + r, width_), source.data(), row);
+  }
+  band_rule_ = nullptr;
+}
+
+void Grid::crop(std::size_t x, std::size_t y, std::size_t w, std::size_t h) {
+  x = std::min(x, width_);
+  y = std::min(y, height_);
+  w = std::min(w, width_ - x);
+  h = std::min(h, height_ - y);
+  replaceCells(copyRegion(x, y, w, h), w, h);
+}
+
+void Grid::pad(std::size_t left, std::size_t top, std::size_t right, std::size_t bottom, uint8_t state) {
+  const std::size_t new_width = width_ + left + right;
+  const std::size_t new_height = height_ + top + bottom;
+
+  std::vector<uint8_t> padded(new_width * new_height, state);
+  for (std::size_t y = 0; y < height_ && width_ > 0; ++y) {
+    std::memcpy(padded.data() + idx(left, y + top, new_width), cells_.data() + y * width_, width_);
+  }
+  replaceCells(std::move(padded), new_width, new_height);
+}
+
+// Blocked transpose with one side mirrored: tiles keep both the rows read and the columns written cache resident
+void Grid::rotate90(bool clockwise) {
+  const std::size_t w = width_;
+  const std::size_t h = height_;
+  std::vector<uint8_t> rotated(w * h);
+
+  for (std::size_t ty = 0; ty < h; ty += TRANSPOSE_TILE) {
+    for (std::size_t tx = 0; tx < w; tx += TRANSPOSE_TILE) {
+      const std::size_t y_end = std::min(ty + TRANSPOSE_TILE, h);
+      const std::size_t x_end = std::min(tx + TRANSPOSE_TILE, w);
+      for (std::size_t y = ty; y < y_end; ++y) {
+        // The new grid is h wide: clockwise (x, y) goes to (h - 1 - y, x), counterclockwise to (y, w - 1 - x)
+        const uint8_t* src = cells_.data() + y * w;
+        if (clockwise) {
+          for (std::size_t x = tx; x < x_end; ++x) rotated[x * h + (h - 1 - y)] = src[x];
+        } else {
+          for (std::size_t x = tx; x < x_end; ++x) rotated[(w - 1 - x) * h + y] = src[x];
+        }
+      }
+    }
+  }
+  replaceCells(std::move(rotated), h, w);
+}
+
+void Grid::rotate180() {
+  std::reverse(cells_.begin(), cells_.end());
+  band_rule_ = nullptr;
+  hash_valid_ = false;
+}
+
+void Grid::flipHorizontal() {
+  for (std::size_t y = 0; y < height_; ++y) {
+    std::reverse(cells_.begin() + static_cast<std::ptrdiff_t>(y * width_), cells_.begin() + static_cast<std::ptrdiff_t>((y + 1) * width_));
+  }
+  band_rule_ = nullptr;
+  hash_valid_ = false;
+}
+
+void Grid::flipVertical() {
+  for (std::size_t top = 0, bottom = height_; top + 1 < bottom; ++top, --bottom) {
+    std::swap_ranges(cells_.begin() + static_cast<std::ptrdiff_t>(top * width_), cells_.begin() + static_cast<std::ptrdiff_t>((top + 1) * width_),
+                     cells_.begin() + static_cast<std::ptrdiff_t>((bottom - 1) * width_));
+  }
+  band_rule_ = nullptr;
+  hash_valid_ = false;
+}
+
+void Grid::writeRow(std::size_t i, const uint8_t* src, std::size_t count) {
+  if (hash_valid_) {
+    for (std::size_t k = 0; k < count; ++k) {
+      hash_ += cell_key(i + k) * (static_cast<uint64_t>(src[k]) - cells_[i + k]);
+    }
+  }
+  std::memcpy(cells_.data() + i, src, count);
+}
+
+void Grid::replaceCells(std::vector<uint8_t>&& cells, std::size_t width, std::size_t height) {
+  cells_ = std::move(cells);
+  width_ = width;
+  height_ = height;
+  new_cells_.clear(); // step sizes it again
+  band_rule_ = nullptr;
+  hash_valid_ = false;
 }
 
 // Changes how future neighbor lookups treat edges
 void Grid::setBoundary(Boundary boundary) {
   boundary_ = boundary;
+  band_rule_ = nullptr;
 }
 
 // Changes which neighbor shape future steps use
 void Grid::setNeighborhood(Neighborhood neighborhood) {
   neighborhood_ = neighborhood;
+  band_rule_ = nullptr;
 }
 
 // Shared neighbor sampler used by Grid and RuleContext
@@ -128,6 +540,16 @@ void Grid::getNeighborsStatic(const std::vector<uint8_t>& cells, std::size_t x,
   neighbors.clear();
   auto deltas = pick_deltas(neighborhood);
 
+  // Interior cells never leave the grid, so every boundary mode (except Clamp which skips all neighbours) reads them directly
+  if (x > 0 && y > 0 && x + 1 < width && y + 1 < height && boundary != Boundary::Clamp && boundary != Boundary::Count) {
+    const uint8_t* center = cells.data() + idx(x, y, width);
+    neighbors.resize(deltas.size());
+    for (std::size_t i = 0; i < deltas.size(); ++i) {
+      neighbors[i] = center[static_cast<std::ptrdiff_t>(deltas[i].second) * static_cast<std::ptrdiff_t>(width) + deltas[i].first];
+    }
+    return;
+  }
+
   for (const auto& delta : deltas) {
     int nx = static_cast<int>(x) + delta.first;
     int ny = static_cast<int>(y) + delta.second;
@@ -188,14 +610,20 @@ std::size_t Grid::getIteration() const {
   return iteration_;
 }
 
+std::size_t Grid::getCellUpdates() const {
+  return cell_updates_;
+}
+
 void Grid::setIteration(std::size_t iteration) {
   iteration_ = iteration;
 }
 
 void Grid::setHeight(std::size_t height) {
   height_ = height;
+  band_rule_ = nullptr;
 }
 
 void Grid::setWidth(std::size_t width) {
   width_ = width;
+  band_rule_ = nullptr;
 }
@@ -70,22 +70,54 @@ public:
        Boundary boundary = Boundary::Wrap, Neighborhood neighborhood = Neighborhood::Moore);
 
   // Advances simulation by one step using provided rule
-  // Rule operates per-cell, using neighbors extracted via current settings
+  // Rule operates per-cell, using neighbors extracted via current settings (runs Rule::preStep first when the rule has one)
+  // Rules with an active band (Rule::hasActiveBand) only get evaluated near the cells that changed in the previous step
   void step(const Rule& rule);
 
+  // Advances one generation of a rerun whose original run is recorded (e.g. after editing the initial state)
+  // Before the call the grid may differ from the original run's current generation only at `differing`, `reference_next`
+  // is the original run's next generation. Only cells the rule's radii let `differing` reach are evaluated, the rest is
+  // copied from reference_next; afterwards `differing` lists the cells that differ from reference_next
+  // Rules without an active band are evaluated everywhere (still correct, just not faster)
+  void replayStep(const Rule& rule, const std::vector<uint8_t>& reference_next, std::vector<std::size_t>& differing);
+
+  // Forces the next step to evaluate every cell (the grid does this itself on edits, use after e.g. swapping rules)
+  void invalidateActiveBand();
+
   void setCell(std::size_t x, std::size_t y, uint8_t state);
   uint8_t getCell(std::size_t x, std::size_t y) const;
 
   // Direct access (use carefully, bypasses abstraction)
+  // The mutable version assumes the caller edits cells, so the next step evaluates the whole grid
   std::vector<uint8_t>& getGridValues();
   const std::vector<uint8_t>& getGridValues() const;
 
   // Bulk replace grid (caller must ensure correct size)
   void setGridValues(const std::vector<uint8_t>& new_grid_values);
+  void setGridValues(std::vector<uint8_t>&& new_grid_values);
 
-  // Resizes grid 
+  // Resizes grid, keeping every cell at its (x, y) (new cells are dead)
   void resize(std::size_t new_width, std::size_t new_height);
 
+  // Region operations: regions are row-major blocks `region_width` cells wide, copied a row at a time
+  // Anything falling outside the grid is clipped
+  // Block of w x h cells at (x, y), cells outside the grid read as dead (like getCell)
+  std::vector<uint8_t> copyRegion(std::size_t x, std::size_t y, std::size_t w, std::size_t h) const;
+  // Writes the region with its top left corner at (x, y)
+  void blit(const std::vector<uint8_t>& region, std::size_t region_width, std::size_t x, std::size_t y);
+  // Like blit, but only where `mask` (same layout as the region) is nonzero
+  void stamp(const std::vector<uint8_t>& region, std::size_t region_width, std::size_t x, std::size_t y, const std::vector<uint8_t>& mask);
+  void fill(std::size_t x, std::size_t y, std::size_t w, std::size_t h, uint8_t state);
+
+  // Whole grid reshapes (the grid takes the new dimensions)
+  // crop keeps the w x h block at (x, y), pad adds dead (or `state`) cells around the edges
+  void crop(std::size_t x, std::size_t y, std::size_t w, std::size_t h);
+  void pad(std::size_t left, std::size_t top, std::size_t right, std::size_t bottom, uint8_t state = 0);
+  void rotate90(bool clockwise = true);
+  void rotate180();
+  void flipHorizontal(); // mirrors left and right
+  void flipVertical();   // mirrors top and bottom
+
   // Runtime config changes (affects future steps)
   void setBoundary(Boundary boundary);
   void setNeighborhood(Neighborhood neighborhood);
@@ -96,6 +128,13 @@ public:
   std::size_t getWidth() const;
   std::size_t getHeight() const;
   std::size_t getIteration() const;
+  // Cells evaluated by rule stages so far (a pre-step and apply on one cell count twice), for profiling
+  std::size_t getCellUpdates() const;
+  // Cells whose state the last step changed (0 means the step left the grid as it was)
+  std::size_t getLastChangeCount() const;
+  // 64-bit hash of the current cells (sum of per-position keys times state), kept up to date by step from the cells it changed
+  // Any other write makes the next call rehash the whole grid
+  uint64_t getHash() const;
   Boundary getBoundary() const;
   Neighborhood getNeighborhood() const;
 
@@ -106,13 +145,47 @@ public:
   ~Grid() = default;
   
 private:
+  // Per-cell function run by one pass over the grid (Rule::preStep or Rule::apply)
+  using Stage = uint8_t (Rule::*)(uint8_t, const RuleContext&, const std::vector<uint8_t>&) const;
+
+  // band == nullptr evaluates every cell, otherwise only the listed ones (the others keep what new_cells_ already holds)
+  // Collects the cells whose output differs from new_cells_ (or from cells_ when compare_with_input) into `changed`
+  // track_hash: that comparison is against the previous generation, so the changed cells are folded into hash_
+  void runStage(const Rule& rule, Stage stage, const std::vector<std::size_t>* band, bool compare_with_input, std::vector<std::size_t>& changed, bool track_hash = false);
+
+  // Rule::preStep and then `apply_stage` on every cell in one pass (see step), the changed cells of the pre-step go to
+  // stage_changed_ and those of apply to `changed`; needs the rule's radii (Rule::hasActiveBand)
+  void runFusedStages(const Rule& rule, Stage apply_stage, std::vector<std::size_t>& changed);
+
+  // Writes `count` cells from src starting at cells_[i] (keeps the hash up to date)
+  void writeRow(std::size_t i, const uint8_t* src, std::size_t count);
+
+  // Takes over cells laid out for new dimensions (everything cached about the old layout goes)
+  void replaceCells(std::vector<uint8_t>&& cells, std::size_t width, std::size_t height);
+
+  // Cells within `radius` (square, wrapping like neighbor lookup) of any seed; false when that is too much of the grid to pay off
+  bool collectBand(const std::vector<std::size_t>& seeds, std::size_t radius, std::vector<std::size_t>& band);
+
   std::size_t width_;
   std::size_t height_;
-  std::size_t iteration_; // tracks simulation progress (useful for UI / debugging)
+  std::size_t iteration_ = 0; // tracks simulation progress (useful for UI / debugging)
+  std::size_t cell_updates_ = 0;
+  std::size_t last_changes_ = 0;
   Boundary boundary_;
   Neighborhood neighborhood_;
 
   std::vector<uint8_t> cells_;     // current state
   std::vector<uint8_t> new_cells_; // next state (double buffer)
 
+  // Active band bookkeeping (see step)
+  const Rule* band_rule_ = nullptr;         // rule the last step ran with, nullptr once anything else touched the cells
+  std::vector<std::size_t> changed_;        // cells whose state changed in the last step
+  std::vector<std::size_t> stage_changed_;  // cells whose pre-step result changed in the current step
+  std::vector<std::size_t> band_;           // cells the current stage evaluates
+  std::vector<uint8_t> band_mark_;          // scratch for collectBand, all zero between calls
+
+  // State hash (see getHash), recomputed lazily after writes step didn't account for
+  mutable uint64_t hash_ = 0;
+  mutable bool hash_valid_ = false;
+
 };
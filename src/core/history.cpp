@@ -0,0 +1,371 @@
+#include "history.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+void put_varint(std::vector<uint8_t>& out, std::size_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+std::size_t get_varint(const uint8_t* data, std::size_t size, std::size_t& pos) {
+  std::size_t value = 0;
+  for (int shift = 0; pos < size; shift += 7) {
+    const uint8_t byte = data[pos++];
+    value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) break;
+  }
+  return value;
+}
+
+}
+
+History::History(std::size_t keyframe_interval, std::size_t cached_frames)
+  : keyframe_interval_(std::max<std::size_t>(keyframe_interval, 1)), cached_frames_(std::max<std::size_t>(cached_frames, 1)) {}
+
+void History::push(const std::vector<uint8_t>& cells) {
+  Frame frame;
+  std::vector<uint8_t> encoded;
+
+  if (last_valid_ && cells == last_) {
+    // Nothing changed (still life, paused rule): point at the first generation with these cells
+    frame.kind = FrameKind::Repeat;
+    frame.source = canonical(frames_.size() - 1);
+  } else if (!last_valid_ || last_.size() != cells.size() || deltas_since_keyframe_ + 1 >= keyframe_interval_) {
+    frame.kind = FrameKind::Keyframe;
+    encode(cells, {}, encoded);
+    deltas_since_keyframe_ = 0;
+  } else {
+    frame.kind = FrameKind::Delta;
+    encode(cells, last_, encoded);
+    ++deltas_since_keyframe_;
+  }
+
+  if (!encoded.empty()) {
+    encoded.shrink_to_fit();
+    frame.data = std::make_shared<const std::vector<uint8_t>>(std::move(encoded));
+  }
+  resident_data_ += frame.dataSize();
+  recorded_.push_back(frames_.size());
+  frames_.push_back(std::move(frame));
+  last_ = cells;
+  last_valid_ = true;
+
+  enforceBudget();
+}
+
+void History::skip(std::size_t count) {
+  if (count == 0) return;
+  frames_.resize(frames_.size() + count);
+  last_valid_ = false;
+}
+
+void History::truncate(std::size_t size) {
+  if (size >= frames_.size()) return;
+
+  for (std::size_t i = size; i < frames_.size(); ++i) {
+    forgetFrame(frames_[i]);
+  }
+  frames_.resize(size);
+  recorded_.erase(std::lower_bound(recorded_.begin(), recorded_.end(), size), recorded_.end());
+  spill_cursor_ = std::min(spill_cursor_, size);
+  cache_.remove_if([size](const CachedFrame& cached) { return cached.generation >= size; });
+  settings_barrier_ = std::min(settings_barrier_, size > 0 ? size - 1 : 0);
+  syncTail();
+}
+
+void History::appendTail(History&& other, std::size_t from) {
+  if (from == 0 || from > other.frames_.size() || frames_.size() != from) {
+    throw std::invalid_argument("History::appendTail: histories don't line up");
+  }
+
+  // Repeats of generations before `from` refer to cells this history has at from - 1
+  const std::size_t joint = canonical(from - 1);
+  for (std::size_t i = from; i < other.frames_.size(); ++i) {
+    Frame& frame = other.frames_[i];
+    if (frame.kind == FrameKind::Repeat && frame.source < from) {
+      frame.source = joint;
+    }
+
+    // Spilled frames keep their file alive through the frame, so they stay where they are
+    if (frame.spill) {
+      spilled_bytes_ += frame.spill_size;
+    } else {
+      resident_data_ += frame.dataSize();
+    }
+    if (frame.kind != FrameKind::Skipped) recorded_.push_back(frames_.size());
+    frames_.push_back(std::move(frame));
+  }
+
+  // The tail still needs whatever settings it was computed with
+  if (other.settings_barrier_ >= from) settings_barrier_ = std::max(settings_barrier_, other.settings_barrier_);
+
+  other.clear();
+  syncTail();
+  enforceBudget();
+}
+
+void History::clear() {
+  frames_.clear();
+  recorded_.clear();
+  cache_.clear();
+  last_.clear();
+  last_valid_ = false;
+  deltas_since_keyframe_ = 0;
+  settings_barrier_ = 0;
+
+  spill_.reset();
+  spill_failed_ = false;
+  spill_cursor_ = 0;
+  resident_data_ = 0;
+  spilled_bytes_ = 0;
+  page_ins_ = 0;
+}
+
+History History::share(std::size_t size) const {
+  History copy(keyframe_interval_, cached_frames_);
+  copy.memory_budget_ = memory_budget_;
+  copy.spill_directory_ = spill_directory_;
+
+  size = std::min(size, frames_.size());
+  copy.frames_.assign(frames_.begin(), frames_.begin() + static_cast<std::ptrdiff_t>(size));
+  copy.recorded_.assign(recorded_.begin(), std::lower_bound(recorded_.begin(), recorded_.end(), size));
+  copy.spill_cursor_ = std::min(spill_cursor_, size);
+  copy.settings_barrier_ = std::min(settings_barrier_, size > 0 ? size - 1 : 0);
+  for (const Frame& frame : copy.frames_) {
+    if (frame.spill) {
+      copy.spilled_bytes_ += frame.spill_size;
+    } else {
+      copy.resident_data_ += frame.dataSize();
+    }
+  }
+
+  copy.syncTail();
+  return copy;
+}
+
+std::size_t History::sharedPrefix(const History& other) const {
+  const std::size_t size = std::min(frames_.size(), other.frames_.size());
+  for (std::size_t i = 0; i < size; ++i) {
+    const Frame& a = frames_[i];
+    const Frame& b = other.frames_[i];
+    if (a.kind != b.kind || a.source != b.source) return i;
+
+    // A frame only one of them spilled since doesn't count (callers then decode and compare it)
+    const bool same_data = a.data ? a.data == b.data : (a.spill ? a.spill == b.spill && a.spill_offset == b.spill_offset : !b.data && !b.spill);
+    if (!same_data) return i;
+  }
+  return size;
+}
+
+bool History::has(std::size_t i) const {
+  return i < frames_.size() && frames_[i].kind != FrameKind::Skipped;
+}
+
+std::optional<std::size_t> History::lastRecorded(std::size_t i) const {
+  auto it = std::upper_bound(recorded_.begin(), recorded_.end(), i);
+  if (it == recorded_.begin()) return std::nullopt;
+  return *(it - 1);
+}
+
+bool History::drop(std::size_t i) {
+  if (!has(i) || frames_[i].pinned) return false;
+  if (i + 1 < frames_.size() && (frames_[i + 1].kind == FrameKind::Delta || frames_[i + 1].kind == FrameKind::Repeat)) {
+    return false;
+  }
+
+  forgetFrame(frames_[i]);
+  frames_[i] = Frame{};
+  recorded_.erase(std::lower_bound(recorded_.begin(), recorded_.end(), i));
+  cache_.remove_if([i](const CachedFrame& cached) { return cached.generation == i; });
+
+  if (i + 1 == frames_.size()) syncTail();
+  return true;
+}
+
+void History::pin(std::size_t i) {
+  if (has(i)) frames_[i].pinned = true;
+}
+
+std::size_t History::frameBytes(std::size_t i) const {
+  if (i >= frames_.size()) return 0;
+  return frames_[i].spill ? frames_[i].spill_size : frames_[i].dataSize();
+}
+
+std::size_t History::canonical(std::size_t i) const {
+  return frames_[i].kind == FrameKind::Repeat ? frames_[i].source : i;
+}
+
+const std::vector<uint8_t>& History::get(std::size_t i) const {
+  if (!has(i)) {
+    throw std::out_of_range("History::get: generation not recorded");
+  }
+
+  const std::size_t target = canonical(i);
+
+  const auto find_cached = [this](std::size_t generation) {
+    return std::find_if(cache_.begin(), cache_.end(), [generation](const CachedFrame& cached) { return cached.generation == generation; });
+  };
+
+  if (auto it = find_cached(target); it != cache_.end()) {
+    cache_.splice(cache_.begin(), cache_, it);
+    return cache_.front().cells;
+  }
+
+  // Walk back to the keyframe (or a cached generation) the target decodes from
+  std::size_t start = target;
+  auto start_cached = cache_.end();
+  while (frames_[start].kind != FrameKind::Keyframe) {
+    --start;
+    start_cached = find_cached(start);
+    if (start_cached != cache_.end()) break;
+  }
+
+  CachedFrame decoded{target, {}};
+  if (start_cached != cache_.end()) {
+    decoded.cells = start_cached->cells;
+  } else {
+    decodeFrame(start, decoded.cells);
+  }
+
+  // Deltas apply in order, repeats don't change anything
+  for (std::size_t g = start + 1; g <= target; ++g) {
+    if (frames_[g].kind == FrameKind::Delta) {
+      decodeFrame(g, decoded.cells);
+    }
+  }
+
+  if (cache_.size() >= cached_frames_) cache_.pop_back();
+  cache_.push_front(std::move(decoded));
+  return cache_.front().cells;
+}
+
+std::size_t History::memoryBytes() const {
+  std::size_t bytes = frames_.capacity() * sizeof(Frame) + last_.capacity() + resident_data_;
+  for (const auto& cached : cache_) {
+    bytes += sizeof(CachedFrame) + cached.cells.capacity();
+  }
+  return bytes;
+}
+
+HistoryStats History::getStats() const {
+  return HistoryStats{memoryBytes(), spilled_bytes_, page_ins_};
+}
+
+void History::decodeFrame(std::size_t i, std::vector<uint8_t>& cells) const {
+  const Frame& frame = frames_[i];
+  if (!frame.spill) {
+    if (frame.data) decode(frame.data->data(), frame.data->size(), cells);
+    return;
+  }
+
+  const std::shared_ptr<const uint8_t> data = frame.spill->read(frame.spill_offset, frame.spill_size);
+  if (!data) throw std::runtime_error("History::get: spilled frame can't be read");
+  ++page_ins_;
+  decode(data.get(), frame.spill_size, cells);
+}
+
+void History::enforceBudget() {
+  if (memory_budget_ == 0 || spill_failed_) return;
+
+  while (resident_data_ > memory_budget_ && spill_cursor_ + 1 < frames_.size()) {
+    Frame& frame = frames_[spill_cursor_];
+
+    if (!frame.spill && frame.data) {
+      if (!spill_) {
+        std::error_code ec;
+        const std::filesystem::path directory = spill_directory_.empty() ? std::filesystem::temp_directory_path(ec) : spill_directory_;
+        auto file = std::make_shared<SpillFile>();
+        if (ec || !file->open(directory)) {
+          spill_failed_ = true; // keep everything in memory rather than lose frames
+          return;
+        }
+        spill_ = std::move(file);
+      }
+
+      std::size_t offset = 0;
+      if (!spill_->append(frame.data->data(), frame.data->size(), offset)) {
+        spill_failed_ = true;
+        return;
+      }
+
+      // Only this history's reference goes, a history sharing the frame keeps it in memory as long as it needs it
+      frame.spill = spill_;
+      frame.spill_offset = offset;
+      frame.spill_size = frame.data->size();
+      resident_data_ -= frame.spill_size;
+      spilled_bytes_ += frame.spill_size;
+      frame.data.reset();
+    }
+
+    ++spill_cursor_;
+  }
+}
+
+void History::forgetFrame(const Frame& frame) {
+  if (frame.spill) {
+    spilled_bytes_ -= frame.spill_size;
+  } else {
+    resident_data_ -= frame.dataSize();
+  }
+}
+
+void History::encode(const std::vector<uint8_t>& cells, const std::vector<uint8_t>& base, std::vector<uint8_t>& out) {
+  out.clear();
+  put_varint(out, cells.size());
+
+  const auto diff = [&](std::size_t i) {
+    return static_cast<uint8_t>(base.empty() ? cells[i] : cells[i] ^ base[i]);
+  };
+
+  std::size_t i = 0;
+  while (i < cells.size()) {
+    const std::size_t run_start = i;
+    while (i < cells.size() && diff(i) == 0) ++i;
+    const std::size_t literal_start = i;
+    while (i < cells.size() && diff(i) != 0) ++i;
+
+    put_varint(out, literal_start - run_start);
+    put_varint(out, i - literal_start);
+    for (std::size_t k = literal_start; k < i; ++k) {
+      out.push_back(diff(k));
+    }
+  }
+}
+
+void History::decode(const uint8_t* data, std::size_t size, std::vector<uint8_t>& cells) {
+  std::size_t pos = 0;
+  const std::size_t cell_count = get_varint(data, size, pos);
+  if (cells.size() != cell_count) cells.assign(cell_count, 0);
+
+  std::size_t i = 0;
+  while (pos < size) {
+    i += get_varint(data, size, pos);
+    const std::size_t literals = get_varint(data, size, pos);
+    for (std::size_t k = 0; k < literals; ++k) {
+      cells[i++] ^= data[pos++];
+    }
+  }
+}
+
+void History::syncTail() {
+  deltas_since_keyframe_ = 0;
+  last_valid_ = false;
+  if (frames_.empty() || frames_.back().kind == FrameKind::Skipped) {
+    last_.clear();
+    return;
+  }
+
+  for (std::size_t i = frames_.size(); i-- > 0 && frames_[i].kind != FrameKind::Keyframe;) {
+    if (frames_[i].kind == FrameKind::Delta) ++deltas_since_keyframe_;
+  }
+
+  last_ = get(frames_.size() - 1);
+  last_valid_ = true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "spill_file.hpp"
+
+// Where a History's bytes currently are (see History::getStats)
+struct HistoryStats {
+  std::size_t resident_bytes = 0; // in memory: encoded frames, bookkeeping, decode buffers
+  std::size_t spilled_bytes = 0;  // encoded frames moved to the spill file
+  std::size_t page_ins = 0;       // spilled frames read back since the history was last cleared
+};
+
+// Recorded generations of a run, stored compactly
+// Every KEYFRAME_INTERVAL-th stored frame is a keyframe (run-length encoded cells), the frames in between only keep
+// what changed since the previous generation (run-length encoded XOR), and a frame equal to the previous one stores
+// nothing at all. So memory follows how much the run changes rather than grid size times generations
+// Frames are decoded on demand; the last few decoded ones are kept in a small LRU cache
+// Once the encoded frames exceed the memory budget the oldest ones spill to an append-only memory-mapped scratch
+// file (SpillFile) and are read back from there when needed, so a long run stays random-access without running out
+// of memory. Per-generation bookkeeping (~50 bytes) and the decode buffers always stay in memory
+// Encoded frames are immutable and reference counted, so share() hands a prefix of the run to another history (a forked
+// timeline, Engine::fork) without copying any of it; each history only ever appends its own new frames
+class History {
+public:
+  static constexpr std::size_t DEFAULT_KEYFRAME_INTERVAL = 64;
+  static constexpr std::size_t DEFAULT_CACHED_FRAMES = 8;
+  static constexpr std::size_t DEFAULT_MEMORY_BUDGET = std::size_t{256} << 20;
+
+  explicit History(std::size_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL, std::size_t cached_frames = DEFAULT_CACHED_FRAMES);
+
+  // Appends the next generation
+  void push(const std::vector<uint8_t>& cells);
+
+  // Appends `count` generations that weren't recorded (Engine::fastForward)
+  void skip(std::size_t count);
+
+  // Drops every generation from `size` on
+  void truncate(std::size_t size);
+
+  // Takes over other's generations from `from` on; this must hold `from` generations, the last one equal to other's
+  // generation from - 1 (e.g. a recomputed run that caught up with the recorded one)
+  void appendTail(History&& other, std::size_t from);
+
+  void clear();
+
+  // Copy of generations [0, size) that shares the encoded frames (and spill files) with this history
+  // Only the per-generation bookkeeping is copied; settings carry over, caches and counters start fresh
+  History share(std::size_t size) const;
+
+  // Number of leading generations both histories hold in the same shared frames (so they are known to be equal
+  // without decoding them), e.g. up to the fork point of two timelines
+  std::size_t sharedPrefix(const History& other) const;
+
+  std::size_t size() const { return frames_.size(); }
+  bool empty() const { return frames_.empty(); }
+
+  // Whether generation i exists and was recorded
+  bool has(std::size_t i) const;
+
+  // Latest recorded generation at or before i, if there is one
+  std::optional<std::size_t> lastRecorded(std::size_t i) const;
+
+  // Recorded generations in increasing order
+  const std::vector<std::size_t>& recordedGenerations() const { return recorded_; }
+
+  // Turns recorded generation i back into an unrecorded one (sparse checkpoints thinning out)
+  // Refused (false) when the next generation is stored relative to it, or it is pinned
+  bool drop(std::size_t i);
+
+  // Keeps recorded generation i from being dropped: one that isn't the step of the one before it (an edit, the last
+  // generation before a settings change) is where replays of the later ones have to start
+  void pin(std::size_t i);
+  bool pinned(std::size_t i) const { return i < frames_.size() && frames_[i].pinned; }
+
+  // Generations up to `i` were computed with other settings (rule, rule parameters, boundary, neighborhood) than the
+  // ones after it, so an unrecorded generation may only be recomputed from a stored one at or after it
+  // Truncating the history below it moves it down: the generations appended next continue from the new last one
+  void setSettingsBarrier(std::size_t i) { settings_barrier_ = i; }
+  std::size_t settingsBarrier() const { return settings_barrier_; }
+
+  // Encoded size of generation i's own frame (0 for repeats and unrecorded generations)
+  std::size_t frameBytes(std::size_t i) const;
+
+  // Decoded generation i (must exist and be recorded)
+  // The reference stays valid until the next call that reads or changes the history
+  const std::vector<uint8_t>& get(std::size_t i) const;
+
+  // Resident bytes (encoded frames still in memory, bookkeeping and decode buffers)
+  // Frames shared with other histories are counted in full by each of them
+  std::size_t memoryBytes() const;
+  HistoryStats getStats() const;
+
+  // Budget for encoded frames kept in memory, 0 = unlimited; applies from the next push
+  void setMemoryBudget(std::size_t bytes) { memory_budget_ = bytes; }
+  std::size_t getMemoryBudget() const { return memory_budget_; }
+
+  // Directory the spill file is created in (system temp directory when empty)
+  void setSpillDirectory(const std::filesystem::path& directory) { spill_directory_ = directory; }
+  const std::filesystem::path& getSpillDirectory() const { return spill_directory_; }
+
+private:
+  enum class FrameKind : uint8_t {
+    Skipped, Keyframe, Delta, Repeat
+  };
+
+  struct Frame {
+    FrameKind kind = FrameKind::Skipped;
+    std::size_t source = 0; // Repeat: earliest generation of the identical run (never a Repeat itself)
+    // Keyframe: encoded cells, Delta: encoded XOR with the previous generation; never changed once pushed
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    std::shared_ptr<SpillFile> spill; // set when the data was moved there (possibly by the history this was shared from)
+    std::size_t spill_offset = 0;
+    std::size_t spill_size = 0;
+    bool pinned = false;    // see pin
+
+    std::size_t dataSize() const { return data ? data->size() : 0; }
+  };
+
+  struct CachedFrame {
+    std::size_t generation;
+    std::vector<uint8_t> cells;
+  };
+
+  // Run-length codec: (unchanged run, literal run) varint pairs, each followed by its literal bytes
+  // Encodes `cells` XOR `base` (an empty base stands for all zeros); decode XORs the literals back into `cells`
+  static void encode(const std::vector<uint8_t>& cells, const std::vector<uint8_t>& base, std::vector<uint8_t>& out);
+  static void decode(const uint8_t* data, std::size_t size, std::vector<uint8_t>& cells);
+
+  // Decodes frame i's data into `cells`, reading it back from the spill file when needed
+  void decodeFrame(std::size_t i, std::vector<uint8_t>& cells) const;
+
+  // Spills the oldest resident frames until the budget holds again (the newest frame always stays)
+  void enforceBudget();
+
+  // Takes a frame's data out of the byte counters (before the frame is discarded)
+  void forgetFrame(const Frame& frame);
+
+  // Generation whose frame holds the data for i (follows Repeat)
+  std::size_t canonical(std::size_t i) const;
+
+  // Recounts deltas_since_keyframe_ and reloads last_ after the end of frames_ moved
+  void syncTail();
+
+  std::size_t keyframe_interval_;
+  std::size_t cached_frames_;
+
+  std::vector<Frame> frames_;
+  std::vector<std::size_t> recorded_;    // generations whose frame isn't Skipped, increasing
+  std::vector<uint8_t> last_;            // decoded last recorded generation (base of the next delta)
+  bool last_valid_ = false;              // false when the last generation wasn't recorded
+  std::size_t deltas_since_keyframe_ = 0;
+  std::size_t settings_barrier_ = 0;
+
+  mutable std::list<CachedFrame> cache_; // most recently used first
+
+  // Memory budget / spill state
+  std::size_t memory_budget_ = DEFAULT_MEMORY_BUDGET;
+  std::filesystem::path spill_directory_;
+  std::shared_ptr<SpillFile> spill_; // this history's own, created on the first spill
+  bool spill_failed_ = false;     // don't retry creating the file on every push
+  std::size_t spill_cursor_ = 0;  // frames before it are spilled or have no data
+  std::size_t resident_data_ = 0; // encoded bytes of frames still in memory
+  std::size_t spilled_bytes_ = 0;
+  mutable std::size_t page_ins_ = 0;
+};
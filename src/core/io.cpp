@@ -1,21 +1,330 @@
 #include "io.hpp"
+#include <array>
+#include <atomic>
+#include <charconv>
 #include <fstream>
 #include <exception>
 #include "json.hpp"
 #include <filesystem>
+#include <string_view>
+#include <utility>
+#include "autosave_journal.hpp"
+#include "mapped_file.hpp"
+#include "pattern_file.hpp"
 #include "convex_hull/convex_hull.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool is_snapshot_name(const std::filesystem::path& path) {
+  return path.extension() == snapshot_file::EXTENSION;
+}
+
+// Temporary name part unique to one save: the UI thread and the IO thread may be saving to the same file
+std::string saving_suffix() {
+  static std::atomic<uint64_t> next = 0;
+  std::string suffix = ".saving" + std::to_string(next.fetch_add(1, std::memory_order_relaxed));
+#if defined(__unix__) || defined(__APPLE__)
+  suffix += "-" + std::to_string(::getpid());
+#endif
+  return suffix;
+}
+
+// Flushes the file (or directory entry list) to the disk; true where there is no such call
+bool sync_to_disk(const std::filesystem::path& path, bool directory) {
+#if defined(__unix__) || defined(__APPLE__)
+  const int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+  if (fd < 0) return false;
+  const bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+#else
+  return true;
+#endif
+}
+
+constexpr char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string base64_encode(const std::vector<uint8_t>& bytes) {
+  std::string out;
+  out.reserve((bytes.size() + 2) / 3 * 4);
+  for (std::size_t i = 0; i < bytes.size(); i += 3) {
+    const std::size_t count = std::min<std::size_t>(3, bytes.size() - i);
+    uint32_t group = static_cast<uint32_t>(bytes[i]) << 16;
+    if (count > 1) group |= static_cast<uint32_t>(bytes[i + 1]) << 8;
+    if (count > 2) group |= bytes[i + 2];
+
+    out.push_back(BASE64_ALPHABET[(group >> 18) & 0x3F]);
+    out.push_back(BASE64_ALPHABET[(group >> 12) & 0x3F]);
+    out.push_back(count > 1 ? BASE64_ALPHABET[(group >> 6) & 0x3F] : '=');
+    out.push_back(count > 2 ? BASE64_ALPHABET[group & 0x3F] : '=');
+  }
+  return out;
+}
+
+bool base64_decode(const std::string& text, std::vector<uint8_t>& bytes) {
+  static const auto values = [] {
+    std::array<int8_t, 256> table{};
+    table.fill(-1);
+    for (int i = 0; i < 64; ++i) table[static_cast<uint8_t>(BASE64_ALPHABET[i])] = static_cast<int8_t>(i);
+    return table;
+  }();
+
+  if (text.size() % 4 != 0) return false;
+  bytes.clear();
+  bytes.reserve(text.size() / 4 * 3);
+  for (std::size_t i = 0; i < text.size(); i += 4) {
+    // Padding only at the very end
+    const std::size_t padding = i + 4 == text.size() ? (text[i + 3] == '=') + (text[i + 2] == '=') : 0;
+    uint32_t group = 0;
+    for (std::size_t k = 0; k < 4; ++k) {
+      const int value = k >= 4 - padding ? 0 : values[static_cast<uint8_t>(text[i + k])];
+      if (value < 0) return false;
+      group = (group << 6) | static_cast<uint32_t>(value);
+    }
+
+    bytes.push_back(static_cast<uint8_t>(group >> 16));
+    if (padding < 2) bytes.push_back(static_cast<uint8_t>(group >> 8));
+    if (padding < 1) bytes.push_back(static_cast<uint8_t>(group));
+  }
+  return true;
+}
+
+// SAX handler for the JSON saves: grid values go straight into the cell vector, no DOM is built
+// Unknown keys (and anything nested in them) are skipped
+class SaveReader {
+public:
+  using number_integer_t = nlohmann::json::number_integer_t;
+  using number_unsigned_t = nlohmann::json::number_unsigned_t;
+  using number_float_t = nlohmann::json::number_float_t;
+  using string_t = nlohmann::json::string_t;
+  using binary_t = nlohmann::json::binary_t;
+
+  explicit SaveReader(SavedGrid& grid) : grid_(grid) {
+    grid_.cells.clear();
+    grid_.rule_parameters.clear();
+  }
+
+  bool null() { return !topLevel(); }
+  bool boolean(bool) { return !topLevel(); }
+  bool number_float(number_float_t, const string_t&) { return !topLevel() && !in_values_; }
+  bool binary(binary_t&) { return !topLevel(); }
+
+  bool number_integer(number_integer_t value) {
+    return value < 0 ? !topLevel() && !in_values_ : number(static_cast<uint64_t>(value));
+  }
+
+  bool number_unsigned(number_unsigned_t value) {
+    return number(value);
+  }
+
+  bool string(string_t& value) {
+    if (!topLevel()) return true;
+
+    if (key_ == "rule") {
+      grid_.rule = std::move(value);
+      seen_ |= RULE;
+    } else if (key_ == "rule_parameters") {
+      grid_.rule_parameters = std::move(value);
+    } else if (key_ == "grid_encoding") {
+      encoding_ = std::move(value);
+    } else if (key_ == "grid_data") {
+      if (!base64_decode(value, data_)) return false;
+      has_data_ = true;
+      seen_ |= CELLS;
+    }
+    return true;
+  }
+
+  bool start_object(std::size_t) {
+    ++depth_;
+    return true;
+  }
+
+  bool end_object() {
+    --depth_;
+    return true;
+  }
+
+  bool start_array(std::size_t) {
+    if (topLevel() && key_ == "grid_values") {
+      in_values_ = true;
+      if (seen_ & WIDTH && seen_ & HEIGHT) grid_.cells.reserve(grid_.width * grid_.height);
+      seen_ |= CELLS;
+    }
+    ++depth_;
+    return true;
+  }
+
+  bool end_array() {
+    --depth_;
+    in_values_ = false;
+    return true;
+  }
+
+  bool key(string_t& value) {
+    if (depth_ == 1) key_ = std::move(value);
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+    return false;
+  }
+
+  // Checks everything required was there and decodes grid_data
+  bool finish() {
+    if ((seen_ & ALL) != ALL) return false;
+
+    if (has_data_) {
+      if (encoding_.empty() || encoding_ == "raw") {
+        grid_.cells = std::move(data_);
+      } else if (encoding_ == "rle") {
+        grid_.cells.resize(grid_.width * grid_.height);
+        if (!snapshot_file::decodeRle(data_.data(), data_.size(), grid_.cells)) return false;
+      } else {
+        return false;
+      }
+    }
+    return grid_.cells.size() == grid_.width * grid_.height;
+  }
+
+private:
+  enum Field : unsigned {
+    WIDTH = 1, HEIGHT = 2, RULE = 4, NEIGHBORHOOD = 8, BOUNDARY = 16, CELLS = 32, ALL = 63
+  };
+
+  // Values directly inside the root object
+  bool topLevel() const {
+    return depth_ == 1;
+  }
+
+  bool number(uint64_t value) {
+    if (in_values_ && depth_ == 2) {
+      if (value > UINT8_MAX) return false;
+      grid_.cells.push_back(static_cast<uint8_t>(value));
+      return true;
+    }
+    if (!topLevel()) return true;
+
+    if (key_ == "width") {
+      grid_.width = static_cast<std::size_t>(value);
+      seen_ |= WIDTH;
+    } else if (key_ == "height") {
+      grid_.height = static_cast<std::size_t>(value);
+      seen_ |= HEIGHT;
+    } else if (key_ == "neighborhood") {
+      if (value >= static_cast<uint64_t>(Neighborhood::Count)) return false;
+      grid_.neighborhood = static_cast<Neighborhood>(value);
+      seen_ |= NEIGHBORHOOD;
+    } else if (key_ == "boundary") {
+      if (value >= static_cast<uint64_t>(Boundary::Count)) return false;
+      grid_.boundary = static_cast<Boundary>(value);
+      seen_ |= BOUNDARY;
+    }
+    return true;
+  }
+
+  SavedGrid& grid_;
+  std::size_t depth_ = 0;
+  bool in_values_ = false;
+  std::string key_;
+  unsigned seen_ = 0;
+  std::string encoding_;
+  bool has_data_ = false;
+  std::vector<uint8_t> data_; // decoded grid_data
+};
+
+// Writes a save as JSON text through a fixed size buffer, the same text nlohmann's dump(4) produces when pretty
+// Compact saves are one line with the cells as base64 (raw or RLE bytes, whichever is shorter) in grid_data
+class SaveWriter {
+public:
+  SaveWriter(std::ofstream& file, bool pretty) : file_(file), pretty_(pretty) {
+    buffer_.reserve(BUFFER_SIZE + 64);
+  }
+
+  void write(const SavedGrid& grid) {
+    append("{");
+    field("boundary", std::to_string(static_cast<int>(grid.boundary)));
+
+    if (pretty_) {
+      newline(1);
+      append("\"grid_values\": [");
+      for (std::size_t i = 0; i < grid.cells.size(); ++i) {
+        if (i > 0) append(",");
+        newline(2);
+        number(grid.cells[i]);
+      }
+      if (!grid.cells.empty()) newline(1);
+      append("],");
+    } else {
+      std::vector<uint8_t> rle;
+      snapshot_file::encodeRle(grid.cells, rle);
+      const bool use_rle = rle.size() < grid.cells.size();
+      field("grid_data", "\"" + base64_encode(use_rle ? rle : grid.cells) + "\"");
+      field("grid_encoding", use_rle ? "\"rle\"" : "\"raw\"");
+    }
+
+    field("height", std::to_string(grid.height));
+    field("neighborhood", std::to_string(static_cast<int>(grid.neighborhood)));
+    field("rule", nlohmann::json(grid.rule).dump());
+    if (!grid.rule_parameters.empty()) field("rule_parameters", nlohmann::json(grid.rule_parameters).dump());
+    field("width", std::to_string(grid.width), true);
+    if (pretty_) append("\n");
+    append("}");
+    flush();
+  }
+
+private:
+  static constexpr std::size_t BUFFER_SIZE = 1 << 16;
+
+  void field(const char* name, const std::string& value, bool last = false) {
+    if (pretty_) newline(1);
+    append("\"");
+    append(name);
+    append(pretty_ ? "\": " : "\":");
+    append(value);
+    if (!last) append(",");
+  }
+
+  void newline(int depth) {
+    if (!pretty_) return;
+    buffer_.push_back('\n');
+    buffer_.append(static_cast<std::size_t>(depth) * 4, ' ');
+  }
+
+  void number(uint8_t value) {
+    char digits[4];
+    const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer_.append(digits, end);
+    if (buffer_.size() >= BUFFER_SIZE) flush();
+  }
+
+  void append(std::string_view text) {
+    buffer_.append(text);
+    if (buffer_.size() >= BUFFER_SIZE) flush();
+  }
+
+  void flush() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+  }
+
+  std::ofstream& file_;
+  bool pretty_;
+  std::string buffer_;
+};
+
+}
+
 // Saves the current grid state and settings to a JSON file. Returns true on success, false on failure.
 // This is currently a bit "hardcoded" but for the app it is for now good enough. In the future this might be a place to look at
 bool IO::saveGridToFile(const Engine& engine, const std::string& filename, bool use_default_folder) {
-  auto grid = engine.getGridConst();
-  nlohmann::json j;
-  j["width"] = grid.getWidth();
-  j["height"] = grid.getHeight();
-  j["grid_values"] = grid.getGridValues();
-  j["rule"] = engine.getRule().getName();
-  j["neighborhood"] = static_cast<int>(grid.getNeighborhood());
-  j["boundary"] = static_cast<int>(grid.getBoundary());
+  // Consistent generation without copying the whole grid (or stopping a running simulation)
+  const SavedGrid grid = toSavedGrid(captureSave(engine));
   std::string full_path = filename;
 
   try {
@@ -23,48 +332,224 @@ bool IO::saveGridToFile(const Engine& engine, const std::string& filename, bool
       std::filesystem::create_directories(DEFAULT_SAVE_FOLDER);
       full_path = DEFAULT_SAVE_FOLDER + filename;
     }
-    std::ofstream file(full_path);
-    file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-    file << j.dump(4); // pretty print with 4 spaces indentation
-    file.close();
   } catch (const std::exception& e) {
     return false;
   }
+  return writeSavedGridAtomically(full_path, grid);
+}
+
+void IO::saveGridToFileAsync(const Engine& engine, const std::string& filename, bool use_default_folder, std::function<void(bool)> on_done) {
+  SaveJob job = captureSave(engine);
+  job.path = use_default_folder ? DEFAULT_SAVE_FOLDER + filename : filename;
+  job.on_done = std::move(on_done);
+  queueSave(std::move(job));
+}
+
+void IO::waitForSaves() {
+  std::unique_lock<std::mutex> lock(save_mtx_);
+  save_cv_.wait(lock, [&] { return save_queue_.empty() && !saving_; });
+}
+
+IO::~IO() {
+  {
+    std::lock_guard<std::mutex> lock(save_mtx_);
+    stopping_ = true;
+  }
+  save_cv_.notify_all();
+  // Before the members the IO thread uses go away
+  if (save_thread_.joinable()) save_thread_.join();
+}
+
+// Holding the snapshot keeps its buffer out of the engine's recycling, so it stays unchanged without being copied
+// The rule comes with it, as it was when the snapshot was published
+IO::SaveJob IO::captureSave(const Engine& engine) {
+  SaveJob job;
+  job.snapshot = engine.getSnapshot();
+  return job;
+}
+
+SavedGrid IO::toSavedGrid(const SaveJob& job) {
+  SavedGrid grid;
+  grid.width = job.snapshot->width;
+  grid.height = job.snapshot->height;
+  grid.boundary = job.snapshot->boundary;
+  grid.neighborhood = job.snapshot->neighborhood;
+  grid.rule = job.snapshot->rule;
+  grid.rule_parameters = job.snapshot->rule_parameters;
+  grid.cells = job.snapshot->cells;
+  return grid;
+}
+
+void IO::queueSave(SaveJob job) {
+  std::lock_guard<std::mutex> lock(save_mtx_);
+  save_queue_.push_back(std::move(job));
+  if (!save_thread_.joinable()) {
+    save_thread_ = std::jthread([this] { runSaves(); });
+  }
+  save_cv_.notify_all();
+}
+
+void IO::runSaves() {
+  std::unique_lock<std::mutex> lock(save_mtx_);
+  while (true) {
+    save_cv_.wait(lock, [&] { return !save_queue_.empty() || stopping_; });
+    if (save_queue_.empty()) return; // stopping, everything written
+
+    SaveJob job = std::move(save_queue_.front());
+    save_queue_.pop_front();
+    saving_ = true;
+    lock.unlock();
+
+    bool success = false;
+    if (job.path.empty()) {
+      success = writeAutosave(job);
+      autosave_queued_.store(false, std::memory_order_relaxed);
+    } else {
+      try {
+        if (job.path.has_parent_path()) std::filesystem::create_directories(job.path.parent_path());
+        success = writeSavedGridAtomically(job.path, toSavedGrid(job));
+      } catch (const std::exception& e) {
+        success = false;
+      }
+    }
+    job.snapshot.reset(); // back to the engine's pool
+    if (job.on_done) job.on_done(success);
+
+    lock.lock();
+    saving_ = false;
+    save_cv_.notify_all();
+  }
+}
+
+bool IO::writeSavedGridAtomically(const std::filesystem::path& path, const SavedGrid& grid) {
+  // The extension stays last, writeSavedGrid picks the format by it
+  std::filesystem::path temporary = path;
+  temporary.replace_filename(path.stem().string() + saving_suffix() + path.extension().string());
+
+  // The contents reach the disk before the rename does, so a crash leaves the old file or the whole new one
+  if (!writeSavedGrid(temporary, grid) || !sync_to_disk(temporary, false)) {
+    std::error_code ec;
+    std::filesystem::remove(temporary, ec);
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    return false;
+  }
+
+  // The rename itself is only durable once the directory is synced; not every file system allows that, and the file
+  // is in place either way
+  sync_to_disk(path.has_parent_path() ? path.parent_path() : std::filesystem::path("."), true);
+  return true;
+}
+
+void IO::setAutosaveInterval(double seconds) {
+  autosave_interval_.store(std::max(seconds, 0.0), std::memory_order_relaxed);
+  next_autosave_ = {};
+}
+
+double IO::getAutosaveInterval() const {
+  return autosave_interval_.load(std::memory_order_relaxed);
+}
+
+void IO::tickAutosave(const Engine& engine) {
+  const double interval = autosave_interval_.load(std::memory_order_relaxed);
+  if (interval <= 0.0) return;
+
+  const auto now = std::chrono::steady_clock::now();
+  if (next_autosave_ == std::chrono::steady_clock::time_point{}) {
+    next_autosave_ = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+    return;
+  }
+  // A slow disk doesn't pile autosaves up, the next one waits for the last
+  if (now < next_autosave_ || autosave_queued_.load(std::memory_order_relaxed)) return;
+
+  next_autosave_ = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+  autosave_queued_.store(true, std::memory_order_relaxed);
+  queueSave(captureSave(engine));
+}
+
+// Appends to the journal while the settings hold and it stays smaller than the snapshot, otherwise starts over
+bool IO::writeAutosave(const SaveJob& job) {
+  const GridSnapshot& snapshot = *job.snapshot;
+  const bool same_settings = autosave_valid_ && snapshot.width == autosave_.width && snapshot.height == autosave_.height &&
+                             snapshot.boundary == autosave_.boundary && snapshot.neighborhood == autosave_.neighborhood &&
+                             snapshot.rule == autosave_.rule && snapshot.rule_parameters == autosave_.rule_parameters;
+  if (same_settings && snapshot.hash == autosave_hash_ && snapshot.cells == autosave_.cells) return true;
+
+  const std::filesystem::path base = DEFAULT_SAVE_FOLDER + AUTOSAVE_NAME + snapshot_file::EXTENSION;
+  const std::filesystem::path journal = DEFAULT_SAVE_FOLDER + AUTOSAVE_NAME + autosave_journal::EXTENSION;
+
+  if (same_settings && autosave_journal_bytes_ < autosave_base_bytes_ && autosave_journal::append(journal, autosave_.cells, snapshot.cells)) {
+    std::error_code ec;
+    autosave_journal_bytes_ = std::filesystem::file_size(journal, ec);
+    autosave_.cells = snapshot.cells;
+    autosave_hash_ = snapshot.hash;
+    return true;
+  }
+
+  // Snapshot first: a crash before the new journal exists leaves the old one, which no longer matches and is ignored
+  autosave_valid_ = false;
+  SavedGrid grid = toSavedGrid(job);
+  try {
+    std::filesystem::create_directories(DEFAULT_SAVE_FOLDER);
+  } catch (const std::exception& e) {
+    return false;
+  }
+  if (!writeSavedGridAtomically(base, grid) || !autosave_journal::create(journal, grid.cells)) return false;
+
+  std::error_code ec;
+  autosave_base_bytes_ = std::filesystem::file_size(base, ec);
+  autosave_journal_bytes_ = 0;
+  autosave_ = std::move(grid);
+  autosave_hash_ = snapshot.hash;
+  autosave_valid_ = true;
   return true;
 }
 
+bool IO::loadAutosave(Engine& engine) {
+  SavedGrid grid;
+  if (!readSavedGrid(DEFAULT_SAVE_FOLDER + AUTOSAVE_NAME + snapshot_file::EXTENSION, grid)) {
+    return false;
+  }
+  // A journal left from an older snapshot doesn't apply (replay refuses it)
+  autosave_journal::replay(DEFAULT_SAVE_FOLDER + AUTOSAVE_NAME + autosave_journal::EXTENSION, grid.cells);
+  return applySavedGrid(engine, grid);
+}
+
 // Loads the grid state and settings from a JSON file. Returns true on success, false on failure.
 // Same issue with this as mentioned above
 bool IO::loadGridFromFile(Engine& engine, const std::string& filename) {
-  nlohmann::json j;
-  try {
-    std::ifstream file(filename);
-    file >> j;
-    file.close();
-  } catch (const std::exception& e) {
+  SavedGrid grid;
+  if (!readSavedGrid(filename, grid)) {
     return false;
   }
+  return applySavedGrid(engine, grid);
+}
+
+bool IO::applySavedGrid(Engine& engine, SavedGrid& grid) {
   try {
+    // Patterns whose rule string matches no registered rule run under the current rule
+    if (grid.rule.empty()) {
+      const auto snapshot = engine.getSnapshot();
+      grid.rule = snapshot->rule;
+      grid.rule_parameters = snapshot->rule_parameters;
+    }
+    auto rule = RuleRegistry::getInstance().make(grid.rule);
+    rule->setParameters(grid.rule_parameters);
+
     engine.reset();
-    std::size_t width = j.at("width").get<std::size_t>();
-    std::size_t height = j.at("height").get<std::size_t>();
-    std::vector<uint8_t> grid_values = j.at("grid_values").get<std::vector<uint8_t>>();
-    std::string rule_name = j.at("rule").get<std::string>();
-    Neighborhood neighborhood = static_cast<Neighborhood>(j.at("neighborhood").get<int>());
-    Boundary boundary = static_cast<Boundary>(j.at("boundary").get<int>());
-
-    engine.resizeGrid(width, height);
-    engine.setGridValues(grid_values);
-    engine.setNeighborhood(neighborhood);
-    engine.setBoundary(boundary);
-    engine.setRule(RuleRegistry::getInstance().make(rule_name));
-
-    // TODO: handle this differently
-    if (rule_name == CONVEX_HULL_RULE_NAME) {
-      engine.setCalculatingDistances(true);
-      engine.setDistanceCalculator(ConvexHull::calculateDistances);
-    } else {
-      engine.setCalculatingDistances(false);
+    engine.resizeGrid(grid.width, grid.height);
+    engine.setGridValues(std::move(grid.cells));
+    engine.setNeighborhood(grid.neighborhood);
+    engine.setBoundary(grid.boundary);
+    engine.setRule(std::move(rule));
+
+    // Convex Hull keeps its distance bits, other rules should not inherit them
+    if (grid.rule != CONVEX_HULL_RULE_NAME) {
       engine.resetDistances();
     }
 
@@ -74,3 +559,70 @@ bool IO::loadGridFromFile(Engine& engine, const std::string& filename) {
   }
   return true;
 }
+
+bool IO::readSavedGrid(const std::filesystem::path& path, SavedGrid& grid) {
+  if (snapshot_file::isSnapshot(path)) {
+    return snapshot_file::read(path, grid);
+  }
+  if (pattern_file::isPatternName(path)) {
+    return pattern_file::read(path, grid);
+  }
+
+  const MappedFile file(path);
+  if (!file.data()) return false;
+
+  SaveReader reader(grid);
+  const char* text = reinterpret_cast<const char*>(file.data());
+  try {
+    if (!nlohmann::json::sax_parse(text, text + file.size(), &reader)) return false;
+  } catch (const std::exception& e) {
+    return false;
+  }
+  return reader.finish();
+}
+
+bool IO::writeSavedGrid(const std::filesystem::path& path, const SavedGrid& grid) {
+  if (is_snapshot_name(path)) {
+    return snapshot_file::write(path, grid);
+  }
+  if (pattern_file::isPatternName(path)) {
+    return pattern_file::write(path, grid);
+  }
+
+  try {
+    std::ofstream file(path, std::ios::binary);
+    file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    SaveWriter writer(file, !compact_json_);
+    writer.write(grid);
+    file.close();
+  } catch (const std::exception& e) {
+    return false;
+  }
+  return true;
+}
+
+void IO::setCompactJson(bool compact) {
+  compact_json_ = compact;
+}
+
+bool IO::isCompactJson() const {
+  return compact_json_;
+}
+
+std::size_t IO::convertFolder(const std::filesystem::path& folder, bool to_json) {
+  std::size_t converted = 0;
+  std::error_code ec;
+  for (auto it = std::filesystem::recursive_directory_iterator(folder, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+    const std::filesystem::path& source = it->path();
+    if (!it->is_regular_file(ec)) continue;
+    if (to_json ? !is_snapshot_name(source) : source.extension() != ".json") continue;
+
+    SavedGrid grid;
+    if (!readSavedGrid(source, grid)) continue;
+
+    std::filesystem::path target = source;
+    target.replace_extension(to_json ? ".json" : snapshot_file::EXTENSION);
+    if (writeSavedGrid(target, grid)) ++converted;
+  }
+  return converted;
+}
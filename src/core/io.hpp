@@ -1,23 +1,37 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include "engine.hpp"
+#include "snapshot_file.hpp"
 
 constexpr std::string DEFAULT_SAVE_FOLDER = "saves/";
 
 // Singleton class for handling input/output of the grid state + other usefull information to/from json files
+// Filenames ending in ".cas" use the binary snapshot format instead (see snapshot_file.hpp), JSON stays for interchange
 
 /*
 * JSON strucutre:
 * width: <grid width>
 * height: <grid height>
 * grid_values: [<list of grid values>]
+* (compact saves instead) grid_encoding: "raw" or "rle", grid_data: <base64 of the cells or of their RLE bytes>
 * rule: <rule name>
+* rule_parameters: <Rule::getParameters> (only present when not empty)
 * neighborhood: <neighborhood type>
 * boundary: <boundary type>
 */
 
 constexpr bool USE_DEFAULT_SAVE_FOLDER = true;
 
+// Autosaves go to DEFAULT_SAVE_FOLDER: a full snapshot (AUTOSAVE_NAME + ".cas") and a journal of the changes since
+// (AUTOSAVE_NAME + ".journal", see autosave_journal.hpp)
+constexpr std::string AUTOSAVE_NAME = "autosave";
+
 class IO {
 public:
   // Singleton access
@@ -26,11 +40,89 @@ public:
     return instance;
   }
 
-  // Save current grid state + settings to a JSON file. Returns true on success, false on failure.
+  // Save current grid state + settings to a JSON file (or a binary snapshot, or a .rle/.cells/.mc pattern). Returns true on success, false on failure.
+  // Written under a temporary name and renamed over the file once complete, so a failed save never leaves half a file
   bool saveGridToFile(const Engine& engine, const std::string& filename, bool use_default_folder = USE_DEFAULT_SAVE_FOLDER);
-  // Load grid state + settings from a JSON file. Returns true on success, false on failure.
+
+  // Same, but returns right away: only the engine's current snapshot is taken (no copy of the grid), serializing and
+  // writing happen on the IO thread, one save after the other. `on_done` gets the result there (on the IO thread)
+  void saveGridToFileAsync(const Engine& engine, const std::string& filename, bool use_default_folder = USE_DEFAULT_SAVE_FOLDER,
+                           std::function<void(bool)> on_done = {});
+
+  // Blocks until every queued save (and autosave) is written
+  void waitForSaves();
+
+  // Autosave every `seconds` of wall time (0 = off). The first autosave writes a full snapshot, later ones only append
+  // what changed since the previous one to the journal; a fresh snapshot replaces both once the journal outgrows it or
+  // the grid size or settings changed
+  void setAutosaveInterval(double seconds);
+  double getAutosaveInterval() const;
+
+  // Queues an autosave when one is due (call regularly from one thread, the UI does every frame; cheap otherwise)
+  void tickAutosave(const Engine& engine);
+
+  // Loads the autosave (snapshot plus journal) like loadGridFromFile
+  bool loadAutosave(Engine& engine);
+  // Load grid state + settings from a JSON file or a binary snapshot (told apart by content) or a pattern file (by extension). Returns true on success, false on failure.
   bool loadGridFromFile(Engine& engine, const std::string& filename);
 
+  // File access without an engine (format picked like above), for tools like the save converter
+  bool readSavedGrid(const std::filesystem::path& path, SavedGrid& grid);
+  bool writeSavedGrid(const std::filesystem::path& path, const SavedGrid& grid);
+
+  // Compact JSON: one line, cells as base64 in grid_data instead of the grid_values list (off by default so saves stay
+  // readable by older versions, loading handles both)
+  void setCompactJson(bool compact);
+  bool isCompactJson() const;
+
+  // Writes a binary snapshot next to every JSON save under `folder` (JSON next to every snapshot when to_json)
+  // Returns how many files were converted, files that fail to load are skipped
+  std::size_t convertFolder(const std::filesystem::path& folder, bool to_json = false);
+
+  // Finishes the queued saves
+  ~IO();
+
 private:
   IO() = default;
+
+  // A save waiting for the IO thread: the snapshot it writes and the rule it ran under, taken when it was asked for
+  struct SaveJob {
+    std::shared_ptr<const GridSnapshot> snapshot; // cells, settings and rule
+    std::filesystem::path path; // empty for an autosave
+    std::function<void(bool)> on_done;
+  };
+
+  static SaveJob captureSave(const Engine& engine);
+  static SavedGrid toSavedGrid(const SaveJob& job);
+
+  // Puts the grid into the engine (loadGridFromFile, loadAutosave)
+  bool applySavedGrid(Engine& engine, SavedGrid& grid);
+
+  // writeSavedGrid into a temporary file next to `path`, renamed over it when complete
+  bool writeSavedGridAtomically(const std::filesystem::path& path, const SavedGrid& grid);
+
+  void queueSave(SaveJob job);
+  void runSaves();
+  bool writeAutosave(const SaveJob& job); // IO thread
+
+  std::atomic<bool> compact_json_ = false;
+
+  std::mutex save_mtx_;
+  std::condition_variable save_cv_; // a job queued / one finished / stopping
+  std::deque<SaveJob> save_queue_;
+  bool saving_ = false;             // the IO thread is writing a job it took off the queue
+  bool stopping_ = false;
+  std::jthread save_thread_;        // started with the first save
+
+  // Autosave scheduling (tickAutosave's thread)
+  std::atomic<double> autosave_interval_ = 0.0;
+  std::chrono::steady_clock::time_point next_autosave_{};
+  std::atomic<bool> autosave_queued_ = false;
+
+  // Autosave state of the IO thread: what the snapshot + journal on disk currently add up to
+  bool autosave_valid_ = false;
+  SavedGrid autosave_;              // settings and cells last autosaved
+  uint64_t autosave_hash_ = 0;
+  std::size_t autosave_base_bytes_ = 0;
+  std::size_t autosave_journal_bytes_ = 0;
 };
@@ -0,0 +1,42 @@
+#include "mapped_file.hpp"
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+#if defined(__unix__) || defined(__APPLE__)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat info{};
+  if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+    void* mapped = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped != MAP_FAILED) {
+      ::madvise(mapped, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+      data_ = static_cast<const uint8_t*>(mapped);
+      size_ = static_cast<std::size_t>(info.st_size);
+      mapped_ = true;
+    }
+  }
+  ::close(fd);
+  if (mapped_) return;
+#endif
+  // Plain read where mmap isn't available (or failed)
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return;
+  buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (!buffer_.empty()) data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
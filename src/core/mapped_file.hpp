@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+// Read-only view of a whole file, memory mapped where possible (read into memory otherwise)
+// Loaders parse straight out of it, so the file never gets a second copy on the heap
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // nullptr when the file can't be opened (or is empty)
+  const uint8_t* data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+private:
+  const uint8_t* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<uint8_t> buffer_;
+};
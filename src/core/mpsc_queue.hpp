@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Lock-free multi-producer single-consumer queue
+// Producers push with a single CAS on the head; the consumer takes everything pushed so far in one exchange and walks
+// it oldest first. Nodes are never popped one by one, so the CAS can't run into ABA
+template <class T>
+class MpscQueue {
+public:
+  MpscQueue() = default;
+  ~MpscQueue() {
+    drain([](T&&) {});
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Any thread
+  void push(T value) {
+    Node* node = new Node{std::move(value), head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(node->next, node)) {
+    }
+  }
+
+  // Consumer thread only: calls fn on every item pushed before the call, in push order, and returns how many
+  template <class F>
+  std::size_t drain(F&& fn) {
+    Node* node = head_.exchange(nullptr);
+
+    // The list comes newest first
+    Node* oldest = nullptr;
+    while (node) {
+      Node* next = node->next;
+      node->next = oldest;
+      oldest = node;
+      node = next;
+    }
+
+    std::size_t count = 0;
+    while (oldest) {
+      Node* next = oldest->next;
+      fn(std::move(oldest->value));
+      delete oldest;
+      oldest = next;
+      ++count;
+    }
+    return count;
+  }
+
+  bool empty() const {
+    return head_.load() == nullptr;
+  }
+
+private:
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+  std::atomic<Node*> head_ = nullptr;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Upper bound on the threads parallel_for uses when called from this thread, 0 = one per hardware thread
+// Background work (Engine speculation) sets it so it leaves cores to the rest of the app
+inline thread_local std::size_t parallel_thread_cap = 0;
+
+// Splits [0, count) into contiguous chunks (one per hardware thread) and runs fn(begin, end) on each
+// Used for row-parallel work like Grid::step; the chunks must not write to shared data
+template <class F>
+void parallel_for(std::size_t count, F&& fn) {
+  std::size_t thread_count = std::thread::hardware_concurrency();
+  if (thread_count == 0) {
+    thread_count = 1;
+  }
+  if (parallel_thread_cap > 0) {
+    thread_count = std::min(thread_count, parallel_thread_cap);
+  }
+
+  thread_count = std::min(thread_count, count);
+  if (thread_count <= 1) {
+    if (count > 0) fn(std::size_t{0}, count);
+    return;
+  }
+
+  const std::size_t per_thread = (count + thread_count - 1) / thread_count;
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+
+  for (std::size_t t = 0; t < thread_count; ++t) {
+    const std::size_t begin = t * per_thread;
+    const std::size_t end = std::min(begin + per_thread, count);
+
+    if (begin >= end) {
+      break;
+    }
+
+    threads.emplace_back([&fn, begin, end]() { fn(begin, end); });
+  }
+
+  for (auto& th : threads) {
+    th.join();
+  }
+}
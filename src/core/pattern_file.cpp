@@ -0,0 +1,774 @@
+#include "pattern_file.hpp"
+#include "mapped_file.hpp"
+#include "rules_conway.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+// Largest grid a pattern may load into (a macrocell can describe far more than fits in memory)
+constexpr std::size_t MAX_PATTERN_CELLS = std::size_t{1} << 32;
+constexpr std::size_t RLE_LINE_LENGTH = 70;
+constexpr unsigned MAX_MACROCELL_LEVEL = 62;
+
+// Registered rules that behave like a Life-like rule on two states (rule strings in canonical B/S form)
+struct LifeLikeRule {
+  const char* rule_string;
+  const char* key;
+};
+
+constexpr LifeLikeRule LIFE_LIKE_RULES[] = {
+  {"B3/S23", CONWAY_RULE_NAME},
+};
+
+bool has_extension(const std::filesystem::path& path, const char* extension) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return ext == extension;
+}
+
+bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && is_space(text.front())) text.remove_prefix(1);
+  while (!text.empty() && is_space(text.back())) text.remove_suffix(1);
+  return text;
+}
+
+template <class T>
+bool parse_number(std::string_view text, T& value) {
+  text = trim(text);
+  const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+// Line by line over the mapped text
+class Lines {
+public:
+  Lines(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+  bool next(std::string_view& line) {
+    if (pos_ >= end_) return false;
+    const char* newline = static_cast<const char*>(std::memchr(pos_, '\n', static_cast<std::size_t>(end_ - pos_)));
+    const char* line_end = newline ? newline : end_;
+    line = std::string_view(pos_, static_cast<std::size_t>(line_end - pos_));
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    pos_ = newline ? newline + 1 : end_;
+    return true;
+  }
+
+  // Whatever comes after the last line returned
+  const char* position() const { return pos_; }
+
+private:
+  const char* pos_;
+  const char* end_;
+};
+
+// Appends text to a file through a fixed size buffer
+class TextWriter {
+public:
+  explicit TextWriter(const std::filesystem::path& path) : file_(path, std::ios::binary | std::ios::trunc) {
+    buffer_.reserve(BUFFER_SIZE + 64);
+  }
+
+  void put(char c) {
+    buffer_.push_back(c);
+    if (buffer_.size() >= BUFFER_SIZE) flush();
+  }
+
+  void put(std::string_view text) {
+    buffer_.append(text);
+    if (buffer_.size() >= BUFFER_SIZE) flush();
+  }
+
+  void number(std::size_t value) {
+    char digits[24];
+    const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    put(std::string_view(digits, static_cast<std::size_t>(end - digits)));
+  }
+
+  bool finish() {
+    flush();
+    file_.close();
+    return static_cast<bool>(file_);
+  }
+
+private:
+  static constexpr std::size_t BUFFER_SIZE = 1 << 16;
+
+  void flush() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+  }
+
+  std::ofstream file_;
+  std::string buffer_;
+};
+
+// An empty pattern still gets a single dead cell, grids are never 0 wide
+bool allocate(SavedGrid& grid, std::size_t width, std::size_t height) {
+  width = std::max<std::size_t>(width, 1);
+  height = std::max<std::size_t>(height, 1);
+  if (height > MAX_PATTERN_CELLS / width) return false;
+  grid.width = width;
+  grid.height = height;
+  grid.cells.assign(width * height, 0);
+  return true;
+}
+
+bool is_two_state(const std::vector<uint8_t>& cells) {
+  return std::all_of(cells.begin(), cells.end(), [](uint8_t cell) { return cell <= 1; });
+}
+
+// Sets the rule fields from a rule string, "<rule>:T<w>,<h>" marks a torus of that size
+void apply_rule_string(std::string_view rule, SavedGrid& grid, std::optional<std::pair<std::size_t, std::size_t>>* torus) {
+  if (const std::size_t colon = rule.find(':'); colon != std::string_view::npos) {
+    std::string_view topology = trim(rule.substr(colon + 1));
+    rule = rule.substr(0, colon);
+
+    std::size_t w = 0;
+    std::size_t h = 0;
+    const std::size_t comma = topology.find(',');
+    if (torus && !topology.empty() && (topology.front() == 'T' || topology.front() == 't') && comma != std::string_view::npos &&
+        parse_number(topology.substr(1, comma - 1), w) && parse_number(topology.substr(comma + 1), h) && w > 0 && h > 0) {
+      *torus = std::make_pair(w, h);
+    }
+  }
+  grid.rule = pattern_file::ruleKeyFor(std::string(trim(rule)));
+}
+
+// ---- RLE ----
+
+bool read_rle(const MappedFile& file, SavedGrid& grid) {
+  const char* begin = reinterpret_cast<const char*>(file.data());
+  Lines lines(begin, begin + file.size());
+
+  // Comments (#...) up to the "x = .., y = .., rule = .." header
+  std::string_view line;
+  do {
+    if (!lines.next(line)) return false;
+    line = trim(line);
+  } while (line.empty() || line.front() == '#');
+
+  std::size_t width = 0;
+  std::size_t height = 0;
+  bool has_width = false;
+  bool has_height = false;
+  std::optional<std::pair<std::size_t, std::size_t>> torus;
+  grid.rule = pattern_file::ruleKeyFor("B3/S23"); // the format's default
+
+  while (!line.empty()) {
+    const std::size_t comma = line.find(',');
+    std::string_view item = line.substr(0, comma);
+    line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+
+    const std::size_t equals = item.find('=');
+    if (equals == std::string_view::npos) return false;
+    const std::string_view key = trim(item.substr(0, equals));
+    const std::string_view value = trim(item.substr(equals + 1));
+
+    if (key == "x") {
+      has_width = parse_number(value, width);
+    } else if (key == "y") {
+      has_height = parse_number(value, height);
+    } else if (key == "rule") {
+      // The rule's own commas (torus size) belong to it, it is always the last item
+      std::string rule(value);
+      if (!line.empty()) rule += "," + std::string(line);
+      apply_rule_string(rule, grid, &torus);
+      line = {};
+    }
+  }
+  if (!has_width || !has_height) return false;
+
+  if (torus) {
+    width = std::max(width, torus->first);
+    height = std::max(height, torus->second);
+  }
+  if (!allocate(grid, width, height)) return false;
+  grid.boundary = torus ? Boundary::Wrap : Boundary::Zero;
+  grid.neighborhood = Neighborhood::Moore;
+
+  // Body: [count]tag tokens straight into the cells (dead runs only move the cursor)
+  const char* pos = lines.position();
+  const char* end = begin + file.size();
+  std::size_t x = 0;
+  std::size_t y = 0;
+  std::size_t count = 0;
+  bool has_count = false;
+
+  while (pos < end) {
+    const char c = *pos++;
+    if (c >= '0' && c <= '9') {
+      if (count > (SIZE_MAX - 9) / 10) return false;
+      count = count * 10 + static_cast<std::size_t>(c - '0');
+      has_count = true;
+      continue;
+    }
+    if (is_space(c)) continue;
+    if (c == '!') break;
+
+    const std::size_t run = has_count ? count : 1;
+    count = 0;
+    has_count = false;
+
+    if (c == '$') {
+      y += run;
+      x = 0;
+      continue;
+    }
+    if (c == '#') {
+      // Comment line inside the body (some writers put them there)
+      const void* newline = std::memchr(pos, '\n', static_cast<std::size_t>(end - pos));
+      pos = newline ? static_cast<const char*>(newline) + 1 : end;
+      continue;
+    }
+
+    uint8_t state = 1; // any letter but b means alive in two state patterns
+    if (c == 'b' || c == '.') {
+      state = 0;
+    } else if (c >= 'A' && c <= 'X') {
+      state = static_cast<uint8_t>(c - 'A' + 1);
+    } else if (c >= 'p' && c <= 'y') {
+      if (pos >= end || *pos < 'A' || *pos > 'X') return false;
+      const int value = 24 * (c - 'p' + 1) + (*pos++ - 'A') + 1;
+      if (value > UINT8_MAX) return false;
+      state = static_cast<uint8_t>(value);
+    } else if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+      return false;
+    }
+
+    // Runs past the declared size are clipped
+    if (state != 0 && y < height && x < width) {
+      std::memset(grid.cells.data() + y * width + x, state, std::min(run, width - x));
+    }
+    x = run > SIZE_MAX - x ? SIZE_MAX : x + run;
+  }
+  return true;
+}
+
+bool write_rle(const std::filesystem::path& path, const SavedGrid& grid) {
+  TextWriter out(path);
+  const bool two_state = is_two_state(grid.cells);
+
+  out.put("x = ");
+  out.number(grid.width);
+  out.put(", y = ");
+  out.number(grid.height);
+
+  const std::string rule = pattern_file::ruleStringFor(grid.rule);
+  if (!rule.empty() && grid.neighborhood == Neighborhood::Moore) {
+    out.put(", rule = ");
+    out.put(rule);
+    if (grid.boundary == Boundary::Wrap) {
+      out.put(":T");
+      out.number(grid.width);
+      out.put(",");
+      out.number(grid.height);
+    }
+  }
+  out.put('\n');
+
+  // Tokens are never split, a line breaks before the one that would pass the limit
+  std::size_t line_length = 0;
+  const auto token = [&](std::size_t run, std::string_view tag) {
+    char digits[24];
+    std::size_t digit_count = 0;
+    if (run > 1) digit_count = static_cast<std::size_t>(std::to_chars(digits, digits + sizeof(digits), run).ptr - digits);
+
+    if (line_length + digit_count + tag.size() > RLE_LINE_LENGTH) {
+      out.put('\n');
+      line_length = 0;
+    }
+    out.put(std::string_view(digits, digit_count));
+    out.put(tag);
+    line_length += digit_count + tag.size();
+  };
+
+  const auto state_tag = [&](uint8_t state, char* tag) -> std::string_view {
+    if (state == 0) {
+      tag[0] = two_state ? 'b' : '.';
+    } else if (two_state) {
+      tag[0] = 'o';
+    } else if (state <= 24) {
+      tag[0] = static_cast<char>('A' + state - 1);
+    } else {
+      tag[0] = static_cast<char>('p' + (state - 25) / 24);
+      tag[1] = static_cast<char>('A' + (state - 25) % 24);
+      return std::string_view(tag, 2);
+    }
+    return std::string_view(tag, 1);
+  };
+
+  // Row ends are written lazily, so empty rows become one "n$" and trailing dead cells are never written
+  std::size_t pending_rows = 0;
+  for (std::size_t y = 0; y < grid.height; ++y) {
+    const uint8_t* row = grid.cells.data() + y * grid.width;
+    std::size_t length = grid.width;
+    while (length > 0 && row[length - 1] == 0) --length;
+
+    if (length > 0) {
+      if (pending_rows > 0) {
+        token(pending_rows, "$");
+        pending_rows = 0;
+      }
+
+      for (std::size_t x = 0; x < length;) {
+        std::size_t run = x + 1;
+        while (run < length && row[run] == row[x]) ++run;
+        char tag[2];
+        token(run - x, state_tag(row[x], tag));
+        x = run;
+      }
+    }
+    ++pending_rows;
+  }
+  token(1, "!");
+  out.put('\n');
+  return out.finish();
+}
+
+// ---- Plaintext ----
+
+bool read_plaintext(const MappedFile& file, SavedGrid& grid) {
+  const char* begin = reinterpret_cast<const char*>(file.data());
+  const char* end = begin + file.size();
+
+  // First pass only measures, the second one fills the cells
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::string_view line;
+  Lines measure(begin, end);
+  while (measure.next(line)) {
+    if (!line.empty() && line.front() == '!') continue;
+    width = std::max(width, line.size());
+    ++height;
+  }
+  if (!allocate(grid, width, height)) return false;
+
+  Lines fill(begin, end);
+  std::size_t y = 0;
+  while (fill.next(line)) {
+    if (!line.empty() && line.front() == '!') continue;
+    uint8_t* row = grid.cells.data() + y * width;
+    for (std::size_t x = 0; x < line.size(); ++x) {
+      if (line[x] == 'O' || line[x] == '*') {
+        row[x] = 1;
+      } else if (line[x] != '.' && !is_space(line[x])) {
+        return false;
+      }
+    }
+    ++y;
+  }
+
+  grid.rule = pattern_file::ruleKeyFor("B3/S23");
+  grid.boundary = Boundary::Zero;
+  grid.neighborhood = Neighborhood::Moore;
+  return true;
+}
+
+bool write_plaintext(const std::filesystem::path& path, const SavedGrid& grid) {
+  TextWriter out(path);
+  out.put("!Name: ");
+  out.put(path.stem().string());
+  out.put('\n');
+
+  for (std::size_t y = 0; y < grid.height; ++y) {
+    const uint8_t* row = grid.cells.data() + y * grid.width;
+    for (std::size_t x = 0; x < grid.width; ++x) {
+      out.put(row[x] ? 'O' : '.');
+    }
+    out.put('\n');
+  }
+  return out.finish();
+}
+
+// ---- Macrocell ----
+
+// Node 0 is the empty node of any level; level 3 nodes with a leaf are 8x8 bitmaps (bit r * 8 + c)
+// Level 1 nodes of multi-state files hold states in `children`
+struct MacroNode {
+  unsigned level = 0;
+  std::array<uint64_t, 4> children{}; // nw, ne, sw, se
+  uint64_t leaf = 0;
+  bool is_leaf = false;
+};
+
+struct Box {
+  uint64_t x0 = UINT64_MAX;
+  uint64_t y0 = UINT64_MAX;
+  uint64_t x1 = 0; // exclusive
+  uint64_t y1 = 0;
+
+  bool empty() const { return x0 >= x1; }
+
+  void add(const Box& other, uint64_t dx, uint64_t dy) {
+    if (other.empty()) return;
+    x0 = std::min(x0, other.x0 + dx);
+    y0 = std::min(y0, other.y0 + dy);
+    x1 = std::max(x1, other.x1 + dx);
+    y1 = std::max(y1, other.y1 + dy);
+  }
+};
+
+class MacrocellReader {
+public:
+  bool parse(const MappedFile& file, SavedGrid& grid) {
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    Lines lines(begin, begin + file.size());
+    nodes_.assign(1, MacroNode{});
+    grid.rule = pattern_file::ruleKeyFor("B3/S23");
+
+    std::string_view line;
+    if (!lines.next(line) || line.substr(0, 2) != "[M") return false;
+
+    while (lines.next(line)) {
+      line = trim(line);
+      if (line.empty()) continue;
+
+      if (line.front() == '#') {
+        if (line.size() > 2 && line[1] == 'R') grid.rule = pattern_file::ruleKeyFor(std::string(trim(line.substr(2))));
+        continue;
+      }
+      if (!(line.front() == '.' || line.front() == '*' || line.front() == '$' ? parseLeaf(line) : parseNode(line))) return false;
+    }
+    if (nodes_.size() < 2) return false;
+
+    // The last node is the root, the pattern keeps its bounding box
+    const uint64_t root = nodes_.size() - 1;
+    boxes_.assign(nodes_.size(), Box{});
+    box_done_.assign(nodes_.size(), false);
+    const Box box = boxOf(root);
+
+    const uint64_t width = box.empty() ? 0 : box.x1 - box.x0;
+    const uint64_t height = box.empty() ? 0 : box.y1 - box.y0;
+    if (width > MAX_PATTERN_CELLS || height > MAX_PATTERN_CELLS || !allocate(grid, width, height)) return false;
+
+    if (!box.empty()) {
+      grid_ = &grid;
+      origin_x_ = box.x0;
+      origin_y_ = box.y0;
+      paint(root, 0, 0);
+    }
+    grid.boundary = Boundary::Zero;
+    grid.neighborhood = Neighborhood::Moore;
+    return true;
+  }
+
+private:
+  bool parseLeaf(std::string_view line) {
+    MacroNode node;
+    node.level = 3;
+    node.is_leaf = true;
+
+    std::size_t row = 0;
+    std::size_t column = 0;
+    for (char c : line) {
+      if (c == '$') {
+        ++row;
+        column = 0;
+      } else if (c == '.' || c == '*') {
+        if (row >= 8 || column >= 8) return false;
+        if (c == '*') node.leaf |= uint64_t{1} << (row * 8 + column);
+        ++column;
+      } else {
+        return false;
+      }
+    }
+    nodes_.push_back(node);
+    return true;
+  }
+
+  bool parseNode(std::string_view line) {
+    std::array<uint64_t, 5> values{};
+    for (auto& value : values) {
+      line = trim(line);
+      const std::size_t space = std::min(line.find(' '), line.size());
+      if (!parse_number(line.substr(0, space), value)) return false;
+      line = line.substr(space);
+    }
+
+    MacroNode node;
+    node.level = static_cast<unsigned>(values[0]);
+    if (node.level < 1 || node.level > MAX_MACROCELL_LEVEL) return false;
+    for (std::size_t k = 0; k < 4; ++k) {
+      node.children[k] = values[k + 1];
+      // Level 1 children are states, the others refer to earlier nodes one level down
+      if (node.level == 1 ? node.children[k] > UINT8_MAX : node.children[k] >= nodes_.size()) return false;
+      if (node.level > 1 && node.children[k] != 0 && nodes_[node.children[k]].level != node.level - 1) return false;
+    }
+    nodes_.push_back(node);
+    return true;
+  }
+
+  // Shared subtrees are measured once
+  const Box& boxOf(uint64_t index) {
+    if (box_done_[index]) return boxes_[index];
+
+    const MacroNode& node = nodes_[index];
+    Box box;
+    if (index == 0) {
+      // empty
+    } else if (node.is_leaf) {
+      for (uint64_t bit = 0; bit < 64; ++bit) {
+        if (node.leaf >> bit & 1) box.add(Box{bit % 8, bit / 8, bit % 8 + 1, bit / 8 + 1}, 0, 0);
+      }
+    } else {
+      const uint64_t half = uint64_t{1} << (node.level - 1);
+      for (std::size_t k = 0; k < 4; ++k) {
+        const uint64_t dx = k % 2 ? half : 0;
+        const uint64_t dy = k / 2 ? half : 0;
+        if (node.level == 1) {
+          if (node.children[k]) box.add(Box{0, 0, 1, 1}, dx, dy);
+        } else if (node.children[k]) {
+          box.add(boxOf(node.children[k]), dx, dy);
+        }
+      }
+    }
+    box_done_[index] = true;
+    boxes_[index] = box;
+    return boxes_[index];
+  }
+
+  void set(uint64_t x, uint64_t y, uint8_t state) {
+    grid_->cells[(y - origin_y_) * grid_->width + (x - origin_x_)] = state;
+  }
+
+  void paint(uint64_t index, uint64_t x, uint64_t y) {
+    const MacroNode& node = nodes_[index];
+    if (node.is_leaf) {
+      for (uint64_t bits = node.leaf; bits; bits &= bits - 1) {
+        const unsigned bit = static_cast<unsigned>(std::countr_zero(bits));
+        set(x + bit % 8, y + bit / 8, 1);
+      }
+      return;
+    }
+
+    const uint64_t half = uint64_t{1} << (node.level - 1);
+    for (std::size_t k = 0; k < 4; ++k) {
+      const uint64_t cx = x + (k % 2 ? half : 0);
+      const uint64_t cy = y + (k / 2 ? half : 0);
+      if (node.level == 1) {
+        if (node.children[k]) set(cx, cy, static_cast<uint8_t>(node.children[k]));
+      } else if (node.children[k]) {
+        paint(node.children[k], cx, cy);
+      }
+    }
+  }
+
+  std::vector<MacroNode> nodes_;
+  std::vector<Box> boxes_;
+  std::vector<bool> box_done_;
+  SavedGrid* grid_ = nullptr;
+  uint64_t origin_x_ = 0;
+  uint64_t origin_y_ = 0;
+};
+
+// Builds the quadtree bottom up with identical subtrees shared (hash consing), nodes are written as they are created
+class MacrocellWriter {
+public:
+  MacrocellWriter(const SavedGrid& grid, TextWriter& out) : grid_(grid), out_(out), two_state_(is_two_state(grid.cells)) {}
+
+  void write() {
+    out_.put("[M2] (ca_tester)\n");
+    const std::string rule = pattern_file::ruleStringFor(grid_.rule);
+    if (!rule.empty() && grid_.neighborhood == Neighborhood::Moore) {
+      out_.put("#R ");
+      out_.put(rule);
+      out_.put('\n');
+    }
+
+    unsigned level = two_state_ ? 3 : 1;
+    while ((uint64_t{1} << level) < std::max(grid_.width, grid_.height)) ++level;
+
+    // An empty pattern still needs a root
+    if (build(level, 0, 0) == 0) {
+      if (two_state_) {
+        out_.put("$\n");
+      } else {
+        out_.put("1 0 0 0 0\n");
+      }
+    }
+  }
+
+private:
+  struct NodeKey {
+    unsigned level;
+    std::array<uint64_t, 4> children;
+    bool operator==(const NodeKey&) const = default;
+  };
+
+  struct NodeKeyHash {
+    std::size_t operator()(const NodeKey& key) const {
+      uint64_t h = key.level;
+      for (uint64_t child : key.children) h = (h ^ child) * 0x9E3779B97F4A7C15ull;
+      return static_cast<std::size_t>(h ^ (h >> 29));
+    }
+  };
+
+  uint8_t cell(uint64_t x, uint64_t y) const {
+    return x < grid_.width && y < grid_.height ? grid_.cells[y * grid_.width + x] : 0;
+  }
+
+  uint64_t build(unsigned level, uint64_t x, uint64_t y) {
+    if (x >= grid_.width || y >= grid_.height) return 0;
+    if (two_state_ && level == 3) return buildLeaf(x, y);
+
+    NodeKey key{level, {}};
+    const uint64_t half = uint64_t{1} << (level - 1);
+    for (std::size_t k = 0; k < 4; ++k) {
+      const uint64_t cx = x + (k % 2 ? half : 0);
+      const uint64_t cy = y + (k / 2 ? half : 0);
+      key.children[k] = level == 1 ? cell(cx, cy) : build(level - 1, cx, cy);
+    }
+    if (key.children == std::array<uint64_t, 4>{}) return 0;
+
+    auto [it, inserted] = nodes_.try_emplace(key, next_);
+    if (inserted) {
+      ++next_;
+      out_.number(level);
+      for (uint64_t child : key.children) {
+        out_.put(' ');
+        out_.number(child);
+      }
+      out_.put('\n');
+    }
+    return it->second;
+  }
+
+  uint64_t buildLeaf(uint64_t x, uint64_t y) {
+    uint64_t bits = 0;
+    for (uint64_t r = 0; r < 8; ++r) {
+      for (uint64_t c = 0; c < 8; ++c) {
+        if (cell(x + c, y + r)) bits |= uint64_t{1} << (r * 8 + c);
+      }
+    }
+    if (bits == 0) return 0;
+
+    auto [it, inserted] = leaves_.try_emplace(bits, next_);
+    if (inserted) {
+      ++next_;
+      // Rows end in '$', dead cells at a row's end and empty rows at the leaf's end are left out
+      std::size_t rows = 8;
+      while (rows > 0 && !((bits >> ((rows - 1) * 8)) & 0xFF)) --rows;
+      for (std::size_t r = 0; r < rows; ++r) {
+        const uint64_t row = (bits >> (r * 8)) & 0xFF;
+        for (std::size_t c = 0; c < 8 && (row >> c); ++c) out_.put(row >> c & 1 ? '*' : '.');
+        out_.put('$');
+      }
+      out_.put('\n');
+    }
+    return it->second;
+  }
+
+  const SavedGrid& grid_;
+  TextWriter& out_;
+  bool two_state_;
+  uint64_t next_ = 1;
+  std::unordered_map<NodeKey, uint64_t, NodeKeyHash> nodes_;
+  std::unordered_map<uint64_t, uint64_t> leaves_;
+};
+
+// "B3/S23", "b3s23", "S23/B3" or "23/3" (survival/birth) to "B3/S23", empty when it isn't a Life-like rule string
+std::string canonical_rule(std::string_view rule) {
+  std::array<bool, 9> birth{};
+  std::array<bool, 9> survival{};
+
+  const auto digits = [](std::string_view text, std::array<bool, 9>& set) {
+    for (char c : text) {
+      if (c < '0' || c > '8') return false;
+      set[static_cast<std::size_t>(c - '0')] = true;
+    }
+    return true;
+  };
+
+  std::string lowered(trim(rule));
+  std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  const std::size_t b = lowered.find('b');
+  const std::size_t s = lowered.find('s');
+
+  if (b == std::string::npos && s == std::string::npos) {
+    const std::size_t slash = lowered.find('/');
+    if (slash == std::string::npos) return {};
+    if (!digits(std::string_view(lowered).substr(0, slash), survival) || !digits(std::string_view(lowered).substr(slash + 1), birth)) return {};
+  } else {
+    if (b == std::string::npos || s == std::string::npos) return {};
+    const auto part = [&](std::size_t start) {
+      std::string_view text = std::string_view(lowered).substr(start + 1);
+      return text.substr(0, std::min(text.find_first_of("/bs"), text.size()));
+    };
+    // Nothing but the two parts and an optional slash
+    if (lowered.size() != 2 + part(b).size() + part(s).size() + (lowered.find('/') != std::string::npos)) return {};
+    if (!digits(part(b), birth) || !digits(part(s), survival)) return {};
+  }
+
+  std::string out = "B";
+  for (int n = 0; n <= 8; ++n) {
+    if (birth[static_cast<std::size_t>(n)]) out += static_cast<char>('0' + n);
+  }
+  out += "/S";
+  for (int n = 0; n <= 8; ++n) {
+    if (survival[static_cast<std::size_t>(n)]) out += static_cast<char>('0' + n);
+  }
+  return out;
+}
+
+}
+
+namespace pattern_file {
+
+bool isPatternName(const std::filesystem::path& path) {
+  return has_extension(path, ".rle") || has_extension(path, ".cells") || has_extension(path, ".mc");
+}
+
+bool read(const std::filesystem::path& path, SavedGrid& grid) {
+  const MappedFile file(path);
+  if (!file.data()) return false;
+
+  grid.rule_parameters.clear();
+  if (has_extension(path, ".rle")) return read_rle(file, grid);
+  if (has_extension(path, ".cells")) return read_plaintext(file, grid);
+  if (has_extension(path, ".mc")) return MacrocellReader().parse(file, grid);
+  return false;
+}
+
+bool write(const std::filesystem::path& path, const SavedGrid& grid) {
+  if (grid.cells.size() != grid.width * grid.height) return false;
+
+  if (has_extension(path, ".rle")) return write_rle(path, grid);
+  if (has_extension(path, ".cells")) return write_plaintext(path, grid);
+  if (has_extension(path, ".mc")) {
+    TextWriter out(path);
+    MacrocellWriter(grid, out).write();
+    return out.finish();
+  }
+  return false;
+}
+
+std::string ruleKeyFor(const std::string& rule_string) {
+  const std::string canonical = canonical_rule(rule_string);
+  for (const LifeLikeRule& rule : LIFE_LIKE_RULES) {
+    if (canonical == rule.rule_string) return rule.key;
+  }
+  return {};
+}
+
+std::string ruleStringFor(const std::string& rule_key) {
+  for (const LifeLikeRule& rule : LIFE_LIKE_RULES) {
+    if (rule_key == rule.key) return rule.rule_string;
+  }
+  return {};
+}
+
+} // namespace pattern_file
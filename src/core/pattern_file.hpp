@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include "snapshot_file.hpp"
+
+// Pattern formats shared with other Life tools (Golly, LifeViewer, the LifeWiki)
+//   .rle   run length encoded ("x = 3, y = 3, rule = B3/S23" header), multi-state letters for states above 1
+//   .cells plaintext, '.' dead and 'O' alive, two states only
+//   .mc    macrocell quadtree (8x8 leaves for two states, level 1 nodes for more)
+// Readers parse straight out of a mapping of the file into the grid's cell vector, writers stream through a small buffer
+// A pattern loads as a grid exactly its bounding box large (".rle" torus rules ":T<w>,<h>" give the grid size instead)
+// with dead cells beyond the edges (Boundary::Zero, Wrap for the torus)
+namespace pattern_file {
+
+// Whether the filename has one of the extensions above
+bool isPatternName(const std::filesystem::path& path);
+
+// Format picked by extension; false when the file can't be read or is malformed
+// grid.rule is the registry key the rule string maps to, empty when no registered rule matches it
+bool read(const std::filesystem::path& path, SavedGrid& grid);
+// Nonzero cells count as alive in .cells (and in the other formats when the grid only holds 0 and 1)
+bool write(const std::filesystem::path& path, const SavedGrid& grid);
+
+// Rule string ("B3/S23", "23/3", ...) <-> registry key, for the registered rules that are Life-like on two states
+std::string ruleKeyFor(const std::string& rule_string);
+std::string ruleStringFor(const std::string& rule_key);
+
+} // namespace pattern_file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Compile-time pattern tables for neighbourhood matching
+// Rules like ShapeEnforcement describe allowed neighbourhoods as lists of patterns with a wildcard value
+// Instead of walking every pattern per cell, the list is compiled once into tables indexed by a packed neighbourhood code
+// (bit i = neighbour i, in the same order as the neighborhood deltas), so matching a whole pattern set is a table load
+
+// Result of compiling up to 32 patterns over N neighbours (bit p of an entry = pattern p matches)
+template <std::size_t N>
+struct PatternTable {
+  static_assert(N <= 8, "packed codes are one byte");
+
+  // Patterns whose fixed positions agree with the alive code (wildcards accept anything)
+  std::array<uint32_t, (1u << N)> value{};
+
+  // Patterns whose fixed positions don't overlap the given code
+  // Used for rules that also require the compared neighbours to have some other bit cleared
+  std::array<uint32_t, (1u << N)> clean{};
+
+  constexpr uint32_t match(uint8_t alive_code) const {
+    return value[alive_code];
+  }
+
+  constexpr uint32_t match(uint8_t alive_code, uint8_t dirty_code) const {
+    return value[alive_code] & clean[dirty_code];
+  }
+};
+
+// Turns a wildcard pattern list into its lookup table (patterns store 0/1 per neighbour or the wildcard)
+template <std::size_t N, std::size_t P>
+constexpr PatternTable<N> compile_patterns(const std::array<std::array<uint8_t, N>, P>& patterns, uint8_t wildcard) {
+  static_assert(P <= 32, "one bit per pattern in a table entry");
+
+  PatternTable<N> table{};
+
+  for (uint32_t code = 0; code < (1u << N); ++code) {
+    for (std::size_t p = 0; p < P; ++p) {
+      bool value_ok = true;
+      bool clean_ok = true;
+
+      for (std::size_t i = 0; i < N; ++i) {
+        if (patterns[p][i] == wildcard) continue;
+
+        const bool bit = ((code >> i) & 1u) != 0;
+        if (bit != ((patterns[p][i] & 0x01) != 0)) value_ok = false;
+        if (bit) clean_ok = false;
+      }
+
+      if (value_ok) table.value[code] |= (1u << p);
+      if (clean_ok) table.clean[code] |= (1u << p);
+    }
+  }
+
+  return table;
+}
+
+// Reads the neighbourhood of an inner cell straight from the grid buffer (no boundary handling, caller checks bounds)
+template <std::size_t N>
+inline std::array<uint8_t, N> gather_neighbours(const std::vector<uint8_t>& cells, std::size_t x, std::size_t y, std::size_t width,
+                                                const std::array<std::pair<int,int>, N>& deltas) {
+  std::array<uint8_t, N> out{};
+  for (std::size_t i = 0; i < N; ++i) {
+    const std::size_t nx = static_cast<std::size_t>(static_cast<int>(x) + deltas[i].first);
+    const std::size_t ny = static_cast<std::size_t>(static_cast<int>(y) + deltas[i].second);
+    out[i] = cells[ny * width + nx];
+  }
+  return out;
+}
+
+// Packs one bit of every neighbour into a code (bit i set when neighbour i has any bit of mask)
+template <std::size_t N>
+inline constexpr uint8_t pack_code(const std::array<uint8_t, N>& neighbours, uint8_t mask) {
+  uint8_t code = 0;
+  for (std::size_t i = 0; i < N; ++i) {
+    if (neighbours[i] & mask) code = static_cast<uint8_t>(code | (1u << i));
+  }
+  return code;
+}
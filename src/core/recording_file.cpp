@@ -0,0 +1,374 @@
+#include "recording_file.hpp"
+#include "entropy_coder.hpp"
+#include <cstring>
+
+namespace {
+
+constexpr char MAGIC[6] = {'C', 'A', 'R', 'E', 'C', 0};
+constexpr char END_MAGIC[8] = {'C', 'A', 'R', 'E', 'C', 'E', 'N', 'D'};
+constexpr std::size_t FIXED_HEADER = 64;
+constexpr std::size_t HEADER_ALIGNMENT = 64;
+constexpr std::size_t INDEX_ENTRY = 32;
+constexpr std::size_t TRAILER = 32;
+
+void put_u16(uint8_t* out, uint16_t value) {
+  for (int i = 0; i < 2; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put_u32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint16_t get_u16(const uint8_t* in) {
+  return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  return value;
+}
+
+uint64_t get_u64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  return value;
+}
+
+}
+
+namespace recording_file {
+
+// ---- Writer ----
+
+std::unique_ptr<Writer> Writer::create(const std::filesystem::path& path, const SavedGrid& settings, std::size_t first_generation,
+                                       std::size_t keyframe_interval) {
+  if (settings.width == 0 || settings.height == 0 || keyframe_interval == 0) return nullptr;
+  if (settings.rule.size() > UINT16_MAX || settings.rule_parameters.size() > UINT16_MAX) return nullptr;
+
+  std::unique_ptr<Writer> writer(new Writer(path, settings, first_generation, keyframe_interval));
+  if (writer->failed_) return nullptr;
+
+  writer->thread_ = std::jthread([raw = writer.get()] { raw->run(); });
+  return writer;
+}
+
+Writer::Writer(const std::filesystem::path& path, const SavedGrid& settings, std::size_t first_generation, std::size_t keyframe_interval)
+  : path_(path), file_(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc), width_(settings.width),
+    height_(settings.height), first_generation_(first_generation), keyframe_interval_(keyframe_interval) {
+  const std::size_t strings = settings.rule.size() + settings.rule_parameters.size();
+  std::vector<uint8_t> header((FIXED_HEADER + strings + HEADER_ALIGNMENT - 1) / HEADER_ALIGNMENT * HEADER_ALIGNMENT, 0);
+
+  std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+  put_u16(header.data() + 6, VERSION);
+  put_u64(header.data() + 8, width_);
+  put_u64(header.data() + 16, height_);
+  put_u64(header.data() + 24, first_generation_);
+  header[32] = static_cast<uint8_t>(settings.boundary);
+  header[33] = static_cast<uint8_t>(settings.neighborhood);
+  put_u16(header.data() + 34, static_cast<uint16_t>(settings.rule.size()));
+  put_u16(header.data() + 36, static_cast<uint16_t>(settings.rule_parameters.size()));
+  put_u64(header.data() + 40, keyframe_interval_);
+  std::memcpy(header.data() + FIXED_HEADER, settings.rule.data(), settings.rule.size());
+  std::memcpy(header.data() + FIXED_HEADER + settings.rule.size(), settings.rule_parameters.data(), settings.rule_parameters.size());
+
+  file_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+  failed_ = !file_;
+  frames_start_ = file_offset_ = header.size();
+  written_bytes_.store(file_offset_, std::memory_order_relaxed);
+}
+
+Writer::~Writer() {
+  finish();
+}
+
+void Writer::put(std::size_t generation, uint64_t hash, const std::vector<uint8_t>& cells) {
+  if (generation < first_generation_ || cells.size() != width_ * height_) return;
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  space_cv_.wait(lock, [&] { return pending_bytes_ < MAX_PENDING_BYTES || finished_; });
+  if (finished_) return;
+
+  // Buffers the writer thread is done with come back here, so a steady run doesn't allocate per generation
+  std::vector<uint8_t> buffer;
+  if (!free_buffers_.empty()) {
+    buffer = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+  }
+  buffer.assign(cells.begin(), cells.end());
+
+  queue_.push_back(Job{generation, hash, std::move(buffer)});
+  pending_bytes_ += cells.size();
+  cv_.notify_one();
+}
+
+void Writer::run() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    cv_.wait(lock, [&] { return !queue_.empty() || finished_; });
+    if (queue_.empty()) return; // finishing and nothing left
+
+    Job job = std::move(queue_.front());
+    queue_.pop_front();
+    const std::size_t bytes = job.cells.size(); // write() may swap the buffer for the previous base
+    lock.unlock();
+
+    write(job);
+
+    lock.lock();
+    pending_bytes_ -= bytes;
+    if (free_buffers_.size() < 4) free_buffers_.push_back(std::move(job.cells));
+    space_cv_.notify_all();
+  }
+}
+
+void Writer::write(Job& job) {
+  if (failed_) return;
+  const std::size_t index = job.generation - first_generation_;
+
+  if (index < entries_.size()) {
+    // Revisited unchanged (rewinding over the recorded run): nothing to do
+    if (entries_[index].rle_size != 0 && entries_[index].hash == job.hash) return;
+    truncate(index);
+  }
+
+  // Generations jumped over stay empty; the delta chain breaks there
+  while (entries_.size() < index) {
+    entries_.push_back(Entry{file_offset_, 0, 0, 0, 0, false});
+    previous_valid_ = false;
+  }
+
+  bool keyframe = !previous_valid_ || entries_.back().keyframe_distance + 1 >= keyframe_interval_;
+  rle_.clear();
+  if (!keyframe) {
+    delta_.resize(job.cells.size());
+    for (std::size_t i = 0; i < delta_.size(); ++i) delta_[i] = job.cells[i] ^ previous_[i];
+    snapshot_file::encodeRle(delta_, rle_);
+
+    // A busy run gets keyframes sooner: reaching any generation never decodes much more than two keyframes' worth
+    if (chain_bytes_ + rle_.size() > keyframe_bytes_) {
+      keyframe = true;
+      rle_.clear();
+    }
+  }
+  if (keyframe) snapshot_file::encodeRle(job.cells, rle_);
+  coded_.clear();
+  entropy_coder::encode(rle_.data(), rle_.size(), coded_);
+  const bool coded = coded_.size() < rle_.size();
+  const std::vector<uint8_t>& frame = coded ? coded_ : rle_;
+  if (rle_.size() > UINT32_MAX) {
+    failed_ = true;
+    return;
+  }
+
+  if (seek_) {
+    file_.seekp(static_cast<std::streamoff>(file_offset_));
+    seek_ = false;
+  }
+  file_.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+  if (!file_) {
+    failed_ = true;
+    return;
+  }
+
+  const uint32_t distance = keyframe ? 0 : entries_.back().keyframe_distance + 1;
+  entries_.push_back(Entry{file_offset_, static_cast<uint32_t>(frame.size()), static_cast<uint32_t>(rle_.size()), job.hash, distance, coded});
+  file_offset_ += frame.size();
+  if (keyframe) {
+    keyframe_bytes_ = rle_.size();
+    chain_bytes_ = 0;
+  } else {
+    chain_bytes_ += rle_.size();
+  }
+
+  previous_.swap(job.cells); // the old base goes back to the free buffers with the job
+  previous_valid_ = true;
+
+  recorded_.store(entries_.size(), std::memory_order_relaxed);
+  written_bytes_.store(file_offset_, std::memory_order_relaxed);
+}
+
+// Frames are contiguous, so dropping generations just moves the write position back to the end of the last one kept
+void Writer::truncate(std::size_t size) {
+  entries_.resize(size);
+  file_offset_ = entries_.empty() ? frames_start_ : entries_.back().offset + entries_.back().size;
+  seek_ = true;
+  previous_valid_ = false; // the kept generation's cells aren't at hand anymore, the next frame is a keyframe
+}
+
+bool Writer::finish() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (result_) return *result_;
+    finished_ = true;
+  }
+  cv_.notify_all();
+  space_cv_.notify_all();
+  if (thread_.joinable()) thread_.join();
+
+  // Index and trailer
+  std::vector<uint8_t> index(entries_.size() * INDEX_ENTRY + TRAILER, 0);
+  for (std::size_t i = 0; i < entries_.size(); ++i) {
+    uint8_t* out = index.data() + i * INDEX_ENTRY;
+    put_u64(out, entries_[i].offset);
+    put_u32(out + 8, entries_[i].size);
+    put_u32(out + 12, entries_[i].rle_size);
+    put_u64(out + 16, entries_[i].hash);
+    put_u32(out + 24, entries_[i].keyframe_distance);
+    out[28] = entries_[i].coded ? 1 : 0;
+  }
+  uint8_t* trailer = index.data() + entries_.size() * INDEX_ENTRY;
+  put_u64(trailer, file_offset_);
+  put_u64(trailer + 8, entries_.size());
+  put_u64(trailer + 16, snapshot_file::checksum(index.data(), entries_.size() * INDEX_ENTRY));
+  std::memcpy(trailer + 24, END_MAGIC, sizeof(END_MAGIC));
+
+  if (!failed_) {
+    file_.seekp(static_cast<std::streamoff>(file_offset_));
+    file_.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+    file_.close();
+    failed_ = !file_;
+  }
+
+  // Frames dropped by a late truncate may still lie beyond the trailer
+  std::error_code ec;
+  if (!failed_) std::filesystem::resize_file(path_, file_offset_ + index.size(), ec);
+  failed_ = failed_ || ec;
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  result_ = !failed_;
+  return *result_;
+}
+
+std::size_t Writer::size() const {
+  return recorded_.load(std::memory_order_relaxed);
+}
+
+std::size_t Writer::fileBytes() const {
+  return written_bytes_.load(std::memory_order_relaxed);
+}
+
+// ---- Reader ----
+
+bool Reader::open(const std::filesystem::path& path) {
+  decoded_.reset();
+  file_ = std::make_unique<MappedFile>(path);
+  const uint8_t* data = file_->data();
+  const std::size_t size = file_->size();
+  if (!data || size < FIXED_HEADER + TRAILER) return false;
+  if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || get_u16(data + 6) != VERSION) return false;
+
+  const uint8_t* trailer = data + size - TRAILER;
+  if (std::memcmp(trailer + 24, END_MAGIC, sizeof(END_MAGIC)) != 0) return false;
+  const uint64_t index_offset = get_u64(trailer);
+  const uint64_t entries = get_u64(trailer + 8);
+  if (index_offset > size - TRAILER || entries != (size - TRAILER - index_offset) / INDEX_ENTRY ||
+      (size - TRAILER - index_offset) % INDEX_ENTRY != 0) {
+    return false;
+  }
+  if (get_u64(trailer + 16) != snapshot_file::checksum(data + index_offset, entries * INDEX_ENTRY)) return false;
+
+  const uint64_t width = get_u64(data + 8);
+  const uint64_t height = get_u64(data + 16);
+  const uint8_t boundary = data[32];
+  const uint8_t neighborhood = data[33];
+  const std::size_t rule_size = get_u16(data + 34);
+  const std::size_t parameters_size = get_u16(data + 36);
+  if (boundary >= static_cast<uint8_t>(Boundary::Count) || neighborhood >= static_cast<uint8_t>(Neighborhood::Count)) return false;
+  if (FIXED_HEADER + rule_size + parameters_size > index_offset) return false;
+  if (width == 0 || height > SIZE_MAX / width) return false;
+
+  const char* strings = reinterpret_cast<const char*>(data + FIXED_HEADER);
+  settings_ = SavedGrid{};
+  settings_.width = width;
+  settings_.height = height;
+  settings_.boundary = static_cast<Boundary>(boundary);
+  settings_.neighborhood = static_cast<Neighborhood>(neighborhood);
+  settings_.rule.assign(strings, rule_size);
+  settings_.rule_parameters.assign(strings + rule_size, parameters_size);
+
+  first_generation_ = get_u64(data + 24);
+  entries_ = entries;
+  index_ = data + index_offset;
+  frames_end_ = index_offset;
+  return true;
+}
+
+const uint8_t* Reader::entry(std::size_t index) const {
+  return index_ + index * INDEX_ENTRY;
+}
+
+bool Reader::has(std::size_t generation) const {
+  if (generation < first_generation_ || generation - first_generation_ >= entries_) return false;
+  return get_u32(entry(generation - first_generation_) + 12) != 0;
+}
+
+std::optional<uint64_t> Reader::hash(std::size_t generation) const {
+  if (!has(generation)) return std::nullopt;
+  return get_u64(entry(generation - first_generation_) + 16);
+}
+
+const std::vector<uint8_t>* Reader::get(std::size_t generation) {
+  if (!has(generation)) return nullptr;
+  const std::size_t index = generation - first_generation_;
+  const std::size_t distance = get_u32(entry(index) + 24);
+  if (distance > index) return nullptr;
+  const std::size_t keyframe = index - distance;
+
+  // Continue from the generation decoded last when it is on the way, otherwise start at the keyframe
+  std::size_t from = keyframe;
+  if (decoded_ && *decoded_ >= keyframe && *decoded_ <= index) {
+    from = *decoded_ + 1;
+  } else if (!applyFrame(keyframe, true)) {
+    decoded_.reset();
+    return nullptr;
+  } else {
+    from = keyframe + 1;
+  }
+
+  for (std::size_t i = from; i <= index; ++i) {
+    if (!applyFrame(i, false)) {
+      decoded_.reset();
+      return nullptr;
+    }
+  }
+  decoded_ = index;
+  return &cells_;
+}
+
+bool Reader::applyFrame(std::size_t index, bool keyframe) {
+  const uint8_t* e = entry(index);
+  const uint64_t offset = get_u64(e);
+  const std::size_t size = get_u32(e + 8);
+  const std::size_t rle_size = get_u32(e + 12);
+  const bool coded = e[28] != 0;
+  if (rle_size == 0 || (get_u32(e + 24) == 0) != keyframe) return false;
+  if (offset > frames_end_ || size > frames_end_ - offset) return false;
+
+  const uint8_t* frame = file_->data() + offset;
+  const uint8_t* rle = frame;
+  if (coded) {
+    rle_.resize(rle_size);
+    if (!entropy_coder::decode(frame, size, rle_.data(), rle_size)) return false;
+    rle = rle_.data();
+  } else if (size != rle_size) {
+    return false;
+  }
+
+  const std::size_t cell_count = settings_.width * settings_.height;
+  if (keyframe) {
+    cells_.resize(cell_count);
+    return snapshot_file::decodeRle(rle, rle_size, cells_);
+  }
+
+  delta_.resize(cell_count);
+  if (!snapshot_file::decodeRle(rle, rle_size, delta_)) return false;
+  for (std::size_t i = 0; i < cell_count; ++i) cells_[i] ^= delta_[i];
+  return true;
+}
+
+} // namespace recording_file
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "mapped_file.hpp"
+#include "snapshot_file.hpp"
+
+// Recording of a whole run (".carec"): every generation from the one recording started at, settings as of the start
+/*
+* Layout (little endian):
+*   0  magic "CAREC" + u8 0 + u16 version
+*   8  u64 width, u64 height, u64 first generation
+*   32 u8 boundary, u8 neighborhood, u16 rule key length, u16 rule parameters length, u16 reserved, u64 keyframe interval
+*   48 reserved up to 64, then the rule key and parameters padded to a multiple of 64
+*   frames, back to back in generation order
+*   index: one 32 byte entry per generation: u64 frame offset, u32 frame size, u32 run-length size (0 = not recorded),
+*          u64 grid hash, u32 keyframe distance, u8 entropy coded, 3 reserved
+*   trailer: u64 index offset, u64 generations, u64 checksum of the index, magic "CARECEND"
+* A frame is the cells (keyframe) or their XOR with the previous generation (delta), run-length encoded like the
+* snapshot Rle payload and then entropy coded (entropy_coder) when that makes it smaller. Generation i's keyframe is
+* entry i's keyframe distance generations before it, and the frames from there to i are contiguous in the file, so
+* any generation is a single read (one seek) plus decoding at most a keyframe interval of frames (fewer when the deltas
+* add up to more than a keyframe)
+*/
+namespace recording_file {
+
+inline constexpr uint16_t VERSION = 1;
+inline constexpr const char* EXTENSION = ".carec";
+inline constexpr std::size_t DEFAULT_KEYFRAME_INTERVAL = 64;
+
+// Frames wait for the writer thread up to this many bytes; beyond it put() blocks until the writer caught up
+inline constexpr std::size_t MAX_PENDING_BYTES = std::size_t{64} << 20;
+
+// Streams generations into a recording on a background thread
+// put() copies the cells and returns, encoding and writing happen on the writer thread
+// The recording follows the run's timeline like History: a generation put again with a different state (an edit, or
+// stepping on after a rewind) replaces it and drops every later one, one put again unchanged (rewinding, scrubbing) is
+// ignored, and generations jumped over (fastForward) stay empty
+class Writer {
+public:
+  // Creates the file; nullptr when it can't be. `settings` gives the grid size and run settings (its cells are unused)
+  static std::unique_ptr<Writer> create(const std::filesystem::path& path, const SavedGrid& settings, std::size_t first_generation,
+                                        std::size_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+  // Finishes the file if finish() wasn't called
+  ~Writer();
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  // Queues generation `generation` (cells of the recording's size, `hash` as Grid::getHash); generations before the
+  // first one are ignored
+  void put(std::size_t generation, uint64_t hash, const std::vector<uint8_t>& cells);
+
+  // Writes what is still queued, the index and the trailer, and closes the file; false when any write failed
+  bool finish();
+
+  // Generations recorded so far (up to the last one the writer thread got to)
+  std::size_t size() const;
+
+  // Bytes written so far
+  std::size_t fileBytes() const;
+
+  std::size_t firstGeneration() const { return first_generation_; }
+
+private:
+  struct Job {
+    std::size_t generation;
+    uint64_t hash;
+    std::vector<uint8_t> cells;
+  };
+
+  struct Entry {
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    uint32_t rle_size = 0;      // 0 for an empty generation
+    uint64_t hash = 0;
+    uint32_t keyframe_distance = 0;
+    bool coded = false;         // entropy coded, otherwise the run-length encoding as it is
+  };
+
+  Writer(const std::filesystem::path& path, const SavedGrid& settings, std::size_t first_generation, std::size_t keyframe_interval);
+
+  void run();
+  void write(Job& job);
+  void truncate(std::size_t size); // writer thread
+
+  std::filesystem::path path_;
+  std::fstream file_;
+  std::size_t width_;
+  std::size_t height_;
+  std::size_t first_generation_;
+  std::size_t keyframe_interval_;
+  bool failed_ = false;
+
+  // Writer thread state
+  std::vector<Entry> entries_;
+  std::size_t frames_start_ = 0;   // end of the header
+  std::size_t file_offset_ = 0;    // end of the last entry's frame
+  bool seek_ = false;              // the file position moved back (truncate)
+  std::vector<uint8_t> previous_;  // cells of the last entry, the base of the next delta
+  bool previous_valid_ = false;
+  std::size_t keyframe_bytes_ = 0; // run-length size of the last keyframe
+  std::size_t chain_bytes_ = 0;    // and of the deltas written since
+  std::vector<uint8_t> delta_;
+  std::vector<uint8_t> rle_;
+  std::vector<uint8_t> coded_;
+
+  mutable std::mutex mtx_;
+  std::condition_variable cv_;         // work queued / finishing
+  std::condition_variable space_cv_;   // queue drained below MAX_PENDING_BYTES
+  std::deque<Job> queue_;
+  std::vector<std::vector<uint8_t>> free_buffers_;
+  std::size_t pending_bytes_ = 0;
+  bool finished_ = false;
+  std::optional<bool> result_;         // finish() already ran
+  std::atomic<std::size_t> recorded_ = 0;
+  std::atomic<std::size_t> written_bytes_ = 0;
+  std::jthread thread_;
+};
+
+// Random access to a finished recording (the file is memory-mapped)
+class Reader {
+public:
+  // false when the file can't be read, isn't a recording (of a known version) or its index fails the checksum
+  bool open(const std::filesystem::path& path);
+
+  // Grid size and run settings (no cells)
+  const SavedGrid& settings() const { return settings_; }
+
+  std::size_t firstGeneration() const { return first_generation_; }
+  // Generations covered: [firstGeneration(), firstGeneration() + size())
+  std::size_t size() const { return entries_; }
+
+  // Whether the generation is in the recording and wasn't jumped over
+  bool has(std::size_t generation) const;
+
+  // Grid hash the generation was recorded with (Grid::getHash), to compare runs without decoding them
+  std::optional<uint64_t> hash(std::size_t generation) const;
+
+  // Decoded cells of the generation, nullptr when it isn't recorded or its frames are damaged
+  // Stepping forward one generation at a time only decodes the new delta
+  // The pointer stays valid until the next call
+  const std::vector<uint8_t>* get(std::size_t generation);
+
+private:
+  const uint8_t* entry(std::size_t index) const;
+  bool applyFrame(std::size_t index, bool keyframe);
+
+  std::unique_ptr<MappedFile> file_;
+  SavedGrid settings_;
+  std::size_t first_generation_ = 0;
+  std::size_t entries_ = 0;
+  const uint8_t* index_ = nullptr;
+  std::size_t frames_end_ = 0;
+
+  std::vector<uint8_t> cells_;
+  std::vector<uint8_t> rle_;
+  std::vector<uint8_t> delta_;
+  std::optional<std::size_t> decoded_; // index the cells hold
+};
+
+} // namespace recording_file
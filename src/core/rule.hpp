@@ -25,6 +25,67 @@ public:
     return apply(current_state, neighbours); // fallback keeps backward compatibility
   }
 
+  // Optional first stage of every generation (e.g. Convex Hull advancing its distance wave)
+  // When hasPreStep() is true Grid::step runs preStep on all cells and then apply on that result
+  // preStep reads its input through current_state/neighbours only: on a full step both stages run in one pass, and ctx's
+  // grid then already holds pre-step results around the cell (apply reads those through ctx as usual)
+  virtual bool hasPreStep() const { return false; }
+  virtual uint8_t preStep(uint8_t current_state, const RuleContext& ctx, const std::vector<uint8_t>& neighbours) const {
+    return current_state;
+  }
+
+  // Optional locality hints that let Grid::step evaluate only the active band (cells near last generation's changes)
+  // preStepRadius/applyRadius: how far (in cells, square) a change in a stage's input can reach that stage's output
+  // requiresFullStep: generations that behave differently from the previous one (time-dependent rules) evaluate everything
+  virtual bool hasActiveBand() const { return false; }
+  virtual std::size_t preStepRadius() const { return 0; }
+  virtual std::size_t applyRadius() const { return 0; }
+  virtual bool requiresFullStep(const Grid& grid) const { return false; }
+
+  // Optional per-run setup, called by the engine with the input state right before its first generation
+  // Returns true when it changed how the rule behaves, so generations recorded with the old setup can't be reused
+  virtual bool beginRun(const Grid& input) const {
+    return false;
+  }
+
+  // Optional convergence test, checked by the engine after every generation (Engine::getConvergedIteration)
+  // True once further generations can't change the result the rule computes
+  virtual bool hasConverged(const Grid& grid) const {
+    return false;
+  }
+
+  // Optional time dependence, used by the engine's cycle detection (Engine::getCycle)
+  // Identifies how the generation stepped from `grid` behaves; the same cells with the same phase must always lead to the
+  // same future. Rules that only look at cell states keep 0, rules reading the iteration return where they are in it
+  virtual std::size_t timePhase(const Grid& grid) const {
+    return 0;
+  }
+
+  // Whether the same input (and phase) always leads to the same generations
+  // Sparse history (Engine::setHistoryMode) recomputes skipped generations instead of storing them, which is refused
+  // for rules that say no (e.g. ones with shared state written while the grid is evaluated in parallel)
+  virtual bool isDeterministic() const {
+    return true;
+  }
+
+  // Optional whole-grid shortcut used by Engine::fastForward
+  // Advances the row-major cell buffer by up to `generations` steps at once and returns how many were covered
+  // A rule may return fewer only when it reached a fixed point (further steps would change nothing)
+  // Default 0 means there is no shortcut and the caller has to step normally
+  virtual std::size_t fastForward(std::vector<uint8_t>& cells, std::size_t width, std::size_t height,
+                                  Neighborhood neighborhood, Boundary boundary, std::size_t generations) const {
+    return 0;
+  }
+
+  // Settings beyond the rule itself (e.g. k of the k-step rules), saved with the grid by IO; empty for rules without any
+  // setParameters gets what getParameters returned and says whether it could use it
+  virtual std::string getParameters() const {
+    return {};
+  }
+  virtual bool setParameters(const std::string& parameters) const {
+    return parameters.empty();
+  }
+
   // Used for UI / rule selection
   virtual std::string getName() const = 0;
 };
@@ -0,0 +1,305 @@
+#include "snapshot_file.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr char MAGIC[6] = {'C', 'A', 'S', 'N', 'A', 'P'};
+constexpr std::size_t FIXED_HEADER = 64;
+constexpr std::size_t HEADER_ALIGNMENT = 64;
+constexpr std::size_t CHECKSUM_OFFSET = 40;
+
+void put_u16(uint8_t* out, uint16_t value) {
+  for (int i = 0; i < 2; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint16_t get_u16(const uint8_t* in) {
+  return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+// Byte by byte so the format doesn't depend on the host, compilers turn it into one load on little endian machines
+uint64_t get_u64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  return value;
+}
+
+std::size_t varint_size(std::size_t value) {
+  std::size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+// Word at a time multiply-rotate hash: catches truncated and corrupted files, not meant to resist tampering
+class Checksum {
+public:
+  void update(const uint8_t* data, std::size_t size) {
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) mix(get_u64(data + i));
+
+    if (i < size) {
+      uint8_t tail[8] = {};
+      std::memcpy(tail, data + i, size - i);
+      mix(get_u64(tail));
+    }
+    length_ += size;
+  }
+
+  uint64_t finish() const {
+    uint64_t z = hash_ ^ length_;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+private:
+  void mix(uint64_t word) {
+    hash_ = std::rotl(hash_ ^ (word * 0x9E3779B97F4A7C15ull), 29) * 0xBF58476D1CE4E5B9ull;
+  }
+
+  uint64_t hash_ = 0x2545F4914F6CDD1Dull;
+  uint64_t length_ = 0;
+};
+
+// The header is hashed with its checksum field zeroed (it is always a whole number of words, so the payload continues
+// on a word boundary)
+uint64_t file_checksum(const uint8_t* header, std::size_t header_size, const uint8_t* payload, std::size_t payload_size) {
+  Checksum checksum;
+  checksum.update(header, CHECKSUM_OFFSET);
+  const uint8_t zero[8] = {};
+  checksum.update(zero, sizeof(zero));
+  checksum.update(header + CHECKSUM_OFFSET + 8, header_size - CHECKSUM_OFFSET - 8);
+  checksum.update(payload, payload_size);
+  return checksum.finish();
+}
+
+using snapshot_file::SnapshotEncoding;
+
+void encode_bit_planes(const std::vector<uint8_t>& cells, uint8_t layers, std::vector<uint8_t>& out) {
+  const std::size_t plane_size = (cells.size() + 7) / 8;
+  for (int bit = 0; bit < 8; ++bit) {
+    if (!(layers & (1u << bit))) continue;
+
+    const std::size_t start = out.size();
+    out.resize(start + plane_size, 0);
+    uint8_t* plane = out.data() + start;
+    for (std::size_t j = 0; j < plane_size; ++j) {
+      const std::size_t count = std::min<std::size_t>(8, cells.size() - j * 8);
+      const uint8_t* group = cells.data() + j * 8;
+      uint8_t packed = 0;
+      for (std::size_t k = 0; k < count; ++k) {
+        packed |= static_cast<uint8_t>(((group[k] >> bit) & 1u) << k);
+      }
+      plane[j] = packed;
+    }
+  }
+}
+
+bool decode_bit_planes(const uint8_t* data, std::size_t size, uint8_t layers, std::vector<uint8_t>& cells) {
+  const std::size_t plane_size = (cells.size() + 7) / 8;
+  if (size != plane_size * static_cast<std::size_t>(std::popcount(layers))) return false;
+
+  for (int bit = 0; bit < 8; ++bit) {
+    if (!(layers & (1u << bit))) continue;
+
+    for (std::size_t j = 0; j < plane_size; ++j) {
+      const std::size_t count = std::min<std::size_t>(8, cells.size() - j * 8);
+      uint8_t* group = cells.data() + j * 8;
+      for (std::size_t k = 0; k < count; ++k) {
+        group[k] |= static_cast<uint8_t>(((data[j] >> k) & 1u) << bit);
+      }
+    }
+    data += plane_size;
+  }
+  return true;
+}
+
+}
+
+namespace snapshot_file {
+
+void encodeRle(const std::vector<uint8_t>& cells, std::vector<uint8_t>& out) {
+  for (std::size_t i = 0; i < cells.size();) {
+    std::size_t run = i + 1;
+    while (run < cells.size() && cells[run] == cells[i]) ++run;
+
+    std::size_t length = run - i;
+    while (length >= 0x80) {
+      out.push_back(static_cast<uint8_t>(length | 0x80));
+      length >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+    out.push_back(cells[i]);
+    i = run;
+  }
+}
+
+bool decodeRle(const uint8_t* data, std::size_t size, std::vector<uint8_t>& cells) {
+  std::size_t pos = 0;
+  std::size_t i = 0;
+  while (pos < size) {
+    std::size_t length = 0;
+    for (int shift = 0;; shift += 7) {
+      if (pos >= size || shift > 56) return false;
+      const uint8_t byte = data[pos++];
+      length |= static_cast<std::size_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) break;
+    }
+    if (pos >= size || length > cells.size() - i) return false;
+
+    std::memset(cells.data() + i, data[pos++], length);
+    i += length;
+  }
+  return i == cells.size();
+}
+
+uint64_t checksum(const uint8_t* data, std::size_t size) {
+  Checksum checksum;
+  checksum.update(data, size);
+  return checksum.finish();
+}
+
+bool write(const std::filesystem::path& path, const SavedGrid& grid, SnapshotEncoding* encoding) {
+  if (grid.cells.size() != grid.width * grid.height) return false;
+  if (grid.rule.size() > UINT16_MAX || grid.rule_parameters.size() > UINT16_MAX) return false;
+
+  // One pass decides the encoding: which bits are used and how long the RLE stream would be
+  uint8_t layers = 0;
+  std::size_t rle_size = 0;
+  for (std::size_t i = 0; i < grid.cells.size();) {
+    std::size_t run = i + 1;
+    while (run < grid.cells.size() && grid.cells[run] == grid.cells[i]) ++run;
+    layers |= grid.cells[i];
+    rle_size += varint_size(run - i) + 1;
+    i = run;
+  }
+
+  const std::size_t raw_size = grid.cells.size();
+  const std::size_t planes_size = static_cast<std::size_t>(std::popcount(layers)) * ((grid.cells.size() + 7) / 8);
+  SnapshotEncoding picked = SnapshotEncoding::Raw;
+  if (planes_size < raw_size && planes_size <= rle_size) {
+    picked = SnapshotEncoding::BitPlanes;
+  } else if (rle_size < raw_size) {
+    picked = SnapshotEncoding::Rle;
+  }
+
+  std::vector<uint8_t> encoded;
+  const std::vector<uint8_t>* payload = &grid.cells;
+  if (picked == SnapshotEncoding::BitPlanes) {
+    encoded.reserve(planes_size);
+    encode_bit_planes(grid.cells, layers, encoded);
+    payload = &encoded;
+  } else if (picked == SnapshotEncoding::Rle) {
+    encoded.reserve(rle_size);
+    encodeRle(grid.cells, encoded);
+    payload = &encoded;
+  }
+
+  const std::size_t strings = grid.rule.size() + grid.rule_parameters.size();
+  const std::size_t header_size = (FIXED_HEADER + strings + HEADER_ALIGNMENT - 1) / HEADER_ALIGNMENT * HEADER_ALIGNMENT;
+  std::vector<uint8_t> header(header_size, 0);
+  std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+  put_u16(header.data() + 6, VERSION);
+  put_u64(header.data() + 8, grid.width);
+  put_u64(header.data() + 16, grid.height);
+  header[24] = static_cast<uint8_t>(grid.boundary);
+  header[25] = static_cast<uint8_t>(grid.neighborhood);
+  header[26] = static_cast<uint8_t>(picked);
+  header[27] = layers;
+  put_u16(header.data() + 28, static_cast<uint16_t>(grid.rule.size()));
+  put_u16(header.data() + 30, static_cast<uint16_t>(grid.rule_parameters.size()));
+  put_u64(header.data() + 32, payload->size());
+  put_u64(header.data() + 48, header_size);
+  std::memcpy(header.data() + FIXED_HEADER, grid.rule.data(), grid.rule.size());
+  std::memcpy(header.data() + FIXED_HEADER + grid.rule.size(), grid.rule_parameters.data(), grid.rule_parameters.size());
+  put_u64(header.data() + CHECKSUM_OFFSET, file_checksum(header.data(), header_size, payload->data(), payload->size()));
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) return false;
+  file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+  file.write(reinterpret_cast<const char*>(payload->data()), static_cast<std::streamsize>(payload->size()));
+  file.close();
+  if (!file) return false;
+
+  if (encoding) *encoding = picked;
+  return true;
+}
+
+bool read(const std::filesystem::path& path, SavedGrid& grid) {
+  const MappedFile file(path);
+  const uint8_t* data = file.data();
+  if (!data || file.size() < FIXED_HEADER) return false;
+  if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || get_u16(data + 6) != VERSION) return false;
+
+  const uint64_t width = get_u64(data + 8);
+  const uint64_t height = get_u64(data + 16);
+  const uint8_t boundary = data[24];
+  const uint8_t neighborhood = data[25];
+  const uint8_t encoding = data[26];
+  const uint8_t layers = data[27];
+  const std::size_t rule_size = get_u16(data + 28);
+  const std::size_t parameters_size = get_u16(data + 30);
+  const uint64_t payload_size = get_u64(data + 32);
+  const uint64_t header_size = get_u64(data + 48);
+
+  if (boundary >= static_cast<uint8_t>(Boundary::Count) || neighborhood >= static_cast<uint8_t>(Neighborhood::Count) ||
+      encoding >= static_cast<uint8_t>(SnapshotEncoding::Count)) {
+    return false;
+  }
+  if (header_size % HEADER_ALIGNMENT != 0 || header_size < FIXED_HEADER + rule_size + parameters_size ||
+      header_size > file.size() || payload_size != file.size() - header_size) {
+    return false;
+  }
+  if (width != 0 && height > SIZE_MAX / width) return false;
+
+  const uint8_t* payload = data + header_size;
+  if (get_u64(data + CHECKSUM_OFFSET) != file_checksum(data, header_size, payload, payload_size)) return false;
+
+  std::vector<uint8_t> cells;
+  const std::size_t cell_count = width * height;
+  switch (static_cast<SnapshotEncoding>(encoding)) {
+    case SnapshotEncoding::Raw:
+      if (payload_size != cell_count) return false;
+      cells.assign(payload, payload + payload_size);
+      break;
+    case SnapshotEncoding::BitPlanes:
+      cells.assign(cell_count, 0);
+      if (!decode_bit_planes(payload, payload_size, layers, cells)) return false;
+      break;
+    case SnapshotEncoding::Rle:
+      cells.resize(cell_count);
+      if (!decodeRle(payload, payload_size, cells)) return false;
+      break;
+    default:
+      return false;
+  }
+
+  const char* strings = reinterpret_cast<const char*>(data + FIXED_HEADER);
+  grid.width = width;
+  grid.height = height;
+  grid.boundary = static_cast<Boundary>(boundary);
+  grid.neighborhood = static_cast<Neighborhood>(neighborhood);
+  grid.rule.assign(strings, rule_size);
+  grid.rule_parameters.assign(strings + rule_size, parameters_size);
+  grid.cells = std::move(cells);
+  return true;
+}
+
+bool isSnapshot(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(MAGIC)] = {};
+  file.read(magic, sizeof(magic));
+  return file && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+} // namespace snapshot_file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "grid.hpp"
+
+// Everything a save file holds: one grid state plus the settings to run it
+struct SavedGrid {
+  std::size_t width = 0;
+  std::size_t height = 0;
+  Boundary boundary = Boundary::Wrap;
+  Neighborhood neighborhood = Neighborhood::Moore;
+  std::string rule;             // registry key
+  std::string rule_parameters;  // Rule::getParameters
+  std::vector<uint8_t> cells;   // row-major
+};
+
+// Versioned binary snapshot format (".cas"), the compact alternative to the JSON saves
+/*
+* Layout (little endian):
+*   0  magic "CASNAP" + u16 version
+*   8  u64 width, u64 height
+*   24 u8 boundary, u8 neighborhood, u8 encoding, u8 layers (bit mask of the cell bits any cell uses)
+*   28 u16 rule key length, u16 rule parameters length
+*   32 u64 payload size, u64 checksum (whole file, this field counted as zero), u64 payload offset, u64 reserved
+*   64 rule key, rule parameters, zero padding up to the payload offset (multiple of 64)
+*   payload, see SnapshotEncoding
+*/
+namespace snapshot_file {
+
+inline constexpr uint16_t VERSION = 1;
+inline constexpr const char* EXTENSION = ".cas";
+
+enum class SnapshotEncoding : uint8_t {
+  Raw,       // one byte per cell, loads with a single copy out of the mapping
+  BitPlanes, // one bit per cell for each bit set in `layers` (plane by plane), binary grids take 1/8 of raw
+  Rle,       // (varint run length, state) pairs, for mostly empty grids
+  Count
+};
+
+// Writes `grid` in the smallest encoding (ties go to Raw), false on any I/O error
+// `encoding` (optional) reports the encoding picked
+bool write(const std::filesystem::path& path, const SavedGrid& grid, SnapshotEncoding* encoding = nullptr);
+
+// Maps the file and decodes it, false when it can't be read, isn't a snapshot (of a known version) or fails the checksum
+bool read(const std::filesystem::path& path, SavedGrid& grid);
+
+// Whether the file starts with the snapshot magic (no further checks)
+bool isSnapshot(const std::filesystem::path& path);
+
+// The Rle payload on its own: (varint run length, state) pairs
+// decodeRle fills `cells` (already sized) and fails unless the runs cover it exactly
+void encodeRle(const std::vector<uint8_t>& cells, std::vector<uint8_t>& out);
+bool decodeRle(const uint8_t* data, std::size_t size, std::vector<uint8_t>& cells);
+
+// The file checksum on its own (word-wise, detects truncation and corruption, not tampering)
+uint64_t checksum(const uint8_t* data, std::size_t size);
+
+} // namespace snapshot_file
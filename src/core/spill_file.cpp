@@ -0,0 +1,159 @@
+#include "spill_file.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Random name so several engines (or app instances) can share the scratch directory
+std::filesystem::path scratch_name(const std::filesystem::path& directory) {
+  static thread_local std::mt19937_64 rng{std::random_device{}()};
+  return directory / ("ca_history_" + std::to_string(rng()) + ".spill");
+}
+
+}
+
+SpillFile::~SpillFile() {
+  close();
+}
+
+std::size_t SpillFile::size() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return size_;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool SpillFile::open(const std::filesystem::path& directory) {
+  close();
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+
+  for (int attempt = 0; attempt < 4; ++attempt) {
+    const std::filesystem::path path = scratch_name(directory);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd_ >= 0) {
+      ::unlink(path.c_str()); // lives on through the descriptor only
+      return true;
+    }
+  }
+
+  return false;
+}
+
+SpillFile::Mapping::~Mapping() {
+  if (data) ::munmap(data, size);
+}
+
+void SpillFile::close() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (fd_ >= 0) ::close(fd_); // a mapping still being read keeps the file's pages
+  map_.reset();
+  fd_ = -1;
+  size_ = 0;
+}
+
+bool SpillFile::isOpen() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return fd_ >= 0;
+}
+
+bool SpillFile::append(const uint8_t* data, std::size_t size, std::size_t& offset) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (fd_ < 0) return false;
+
+  std::size_t written = 0;
+  while (written < size) {
+    const ssize_t n = ::pwrite(fd_, data + written, size - written, static_cast<off_t>(size_ + written));
+    if (n <= 0) return false;
+    written += static_cast<std::size_t>(n);
+  }
+
+  offset = size_;
+  size_ += size;
+  return true;
+}
+
+std::shared_ptr<const uint8_t> SpillFile::read(std::size_t offset, std::size_t size) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (fd_ < 0 || offset + size > size_) return nullptr;
+
+  if (!map_ || offset + size > map_->size) {
+    // Pages past the end of the file are never touched, they fill in as appends reach them
+    // The old mapping goes away with its last reader
+    const std::size_t length = std::max({size_, 2 * (map_ ? map_->size : 0), MIN_MAPPING});
+    void* map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) return nullptr;
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->data = static_cast<uint8_t*>(map);
+    mapping->size = length;
+    map_ = std::move(mapping);
+  }
+  return std::shared_ptr<const uint8_t>(map_, map_->data + offset);
+}
+
+#else
+
+bool SpillFile::open(const std::filesystem::path& directory) {
+  close();
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+
+  path_ = scratch_name(directory);
+  file_ = std::fopen(path_.string().c_str(), "w+b");
+  if (!file_) {
+    return false;
+  }
+  return true;
+}
+
+void SpillFile::close() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (file_) {
+    std::fclose(file_);
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+  }
+  file_ = nullptr;
+  size_ = 0;
+}
+
+bool SpillFile::isOpen() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return file_ != nullptr;
+}
+
+bool SpillFile::append(const uint8_t* data, std::size_t size, std::size_t& offset) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (!file_ || std::fseek(file_, 0, SEEK_END) != 0 || std::fwrite(data, 1, size, file_) != size) {
+    return false;
+  }
+
+  offset = size_;
+  size_ += size;
+  return true;
+}
+
+std::shared_ptr<const uint8_t> SpillFile::read(std::size_t offset, std::size_t size) {
+  // Own buffer per read, so another read doesn't overwrite bytes still being decoded
+  auto buffer = std::make_shared<std::vector<uint8_t>>(size);
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (!file_ || std::fseek(file_, static_cast<long>(offset), SEEK_SET) != 0 || std::fread(buffer->data(), 1, size, file_) != size) {
+    return nullptr;
+  }
+  return std::shared_ptr<const uint8_t>(buffer, buffer->data());
+}
+
+#endif
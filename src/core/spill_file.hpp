@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Append-only scratch file for data that doesn't fit the memory budget (History spill)
+// Reads go through a memory mapping of the file (plain reads where mmap isn't available); the mapping reaches past the
+// end of the file and doubles when appends outgrow it, so a growing file is remapped only a logarithmic number of times
+// On POSIX the file is unlinked right after it is created, so nothing is left behind even after a crash
+// Thread-safe: forked histories keep reading frames their parent spilled while the parent keeps appending
+class SpillFile {
+public:
+  SpillFile() = default;
+  ~SpillFile();
+
+  SpillFile(const SpillFile&) = delete;
+  SpillFile& operator=(const SpillFile&) = delete;
+
+  // Creates a fresh file in `directory`, false when that isn't possible
+  bool open(const std::filesystem::path& directory);
+  void close();
+  bool isOpen() const;
+
+  // Appends `size` bytes and reports where they went, false on a write error
+  bool append(const uint8_t* data, std::size_t size, std::size_t& offset);
+
+  // `size` bytes at `offset` (must have been appended), nullptr on a read error
+  // The pointer keeps the mapping it points into alive, a mapping the file outgrew is unmapped once no reader holds it
+  std::shared_ptr<const uint8_t> read(std::size_t offset, std::size_t size);
+
+  // Bytes appended so far
+  std::size_t size() const;
+
+private:
+  mutable std::mutex mtx_;
+  std::size_t size_ = 0;
+
+#if defined(__unix__) || defined(__APPLE__)
+  // Smallest mapping made, later ones double
+  static constexpr std::size_t MIN_MAPPING = std::size_t{1} << 24;
+
+  struct Mapping {
+    uint8_t* data = nullptr;
+    std::size_t size = 0;
+    ~Mapping();
+  };
+
+  int fd_ = -1;
+  std::shared_ptr<Mapping> map_; // current mapping, readers share it
+#else
+  std::FILE* file_ = nullptr;
+  std::filesystem::path path_;
+#endif
+};
@@ -0,0 +1,96 @@
+#include "core/io.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Save/load throughput of the JSON and binary formats on generated grids (plus any saves passed on the command line)
+// Usage: ca_bench_io [save files...]
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int REPEATS = 3;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+SavedGrid generated(std::size_t side, double density, uint8_t states, uint32_t seed) {
+  SavedGrid grid;
+  grid.width = side;
+  grid.height = side;
+  grid.rule = "Conway";
+  grid.cells.resize(side * side, 0);
+
+  std::mt19937 rng(seed);
+  std::bernoulli_distribution alive(density);
+  for (auto& cell : grid.cells) {
+    if (alive(rng)) cell = static_cast<uint8_t>(1 + rng() % states);
+  }
+  return grid;
+}
+
+void bench(const std::string& name, const SavedGrid& grid) {
+  const std::filesystem::path directory = std::filesystem::temp_directory_path();
+  const double megacells = static_cast<double>(grid.cells.size()) / 1e6;
+
+  std::cout << name << " (" << grid.width << "x" << grid.height << ")\n";
+  struct Format {
+    const char* label;
+    const char* extension;
+    bool compact_json;
+  };
+
+  for (const Format& format : {Format{"json", ".json", false}, Format{"compact json", ".json", true}, Format{"cas", snapshot_file::EXTENSION, false}}) {
+    const std::filesystem::path path = directory / (std::string("ca_bench_io") + format.extension);
+    IO::instance().setCompactJson(format.compact_json);
+
+    double write_time = 1e30;
+    double read_time = 1e30;
+    bool ok = true;
+    for (int r = 0; r < REPEATS && ok; ++r) {
+      auto start = Clock::now();
+      ok = IO::instance().writeSavedGrid(path, grid);
+      write_time = std::min(write_time, seconds_since(start));
+
+      SavedGrid loaded;
+      start = Clock::now();
+      ok = ok && IO::instance().readSavedGrid(path, loaded) && loaded.cells == grid.cells;
+      read_time = std::min(read_time, seconds_since(start));
+    }
+
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    std::filesystem::remove(path, ec);
+    if (!ok) {
+      std::cout << "  " << format.label << ": FAILED\n";
+      continue;
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << "  " << std::setw(12) << format.label << ": " << std::setw(10) << size / 1024.0
+              << " KB  save " << std::setw(8) << write_time * 1e3 << " ms (" << megacells / write_time << " Mcells/s)  load "
+              << std::setw(8) << read_time * 1e3 << " ms (" << megacells / read_time << " Mcells/s)\n";
+  }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    SavedGrid grid;
+    if (IO::instance().readSavedGrid(argv[i], grid)) {
+      bench(argv[i], grid);
+    } else {
+      std::cerr << "Can't read " << argv[i] << "\n";
+    }
+  }
+
+  bench("sparse binary", generated(1024, 0.02, 1, 1));
+  bench("dense binary", generated(1024, 0.5, 1, 2));
+  bench("multi-state", generated(1024, 0.5, 15, 3));
+  bench("large sparse binary", generated(4096, 0.02, 1, 4));
+  IO::instance().setCompactJson(false);
+  return 0;
+}
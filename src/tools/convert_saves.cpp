@@ -0,0 +1,28 @@
+#include "core/io.hpp"
+#include <iostream>
+#include <string>
+
+// Converts every JSON save under a folder to a binary snapshot next to it (or back with --to-json)
+// Usage: ca_convert_saves [folder] [--to-json]
+int main(int argc, char* argv[]) {
+  std::filesystem::path folder = DEFAULT_SAVE_FOLDER;
+  bool to_json = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--to-json") {
+      to_json = true;
+    } else {
+      folder = arg;
+    }
+  }
+
+  if (!std::filesystem::is_directory(folder)) {
+    std::cerr << folder << " is not a directory\n";
+    return 1;
+  }
+
+  const std::size_t converted = IO::instance().convertFolder(folder, to_json);
+  std::cout << "Converted " << converted << " file(s) under " << folder << (to_json ? " to JSON\n" : " to binary snapshots\n");
+  return 0;
+}